@@ -0,0 +1,187 @@
+// Scaling benchmark and stress check: dllist_concurrent vs a dllist behind
+// one mutex.
+//
+//   g++ -std=c++17 -O2 -pthread -I.. concurrent_bench.cpp -o concurrent_bench
+//
+// Every run checks that each pushed value is popped exactly once (by sum and
+// count) and aborts otherwise.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../dllist_concurrent.hxx"
+
+namespace {
+
+class locked_dllist
+{
+    private:
+        std::mutex mutex_;
+        dllist<std::uint64_t> list_;
+
+    public:
+        void push_back(std::uint64_t v)
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            list_.push_back(v);
+        }
+
+        bool try_pop_back(std::uint64_t& v)
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            if (list_.empty())
+                return false;
+            v = list_.back();
+            list_.pop_back();
+            return true;
+        }
+
+        bool try_pop_front(std::uint64_t& v)
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            if (list_.empty())
+                return false;
+            v = list_.front();
+            list_.pop_front();
+            return true;
+        }
+};
+
+struct result
+{
+    double mops;
+    std::uint64_t sum;
+    std::uint64_t count;
+};
+
+void check(result const& r, std::uint64_t items)
+{
+    auto expected = items * (items - 1) / 2;
+    if (r.count != items || r.sum != expected)
+    {
+        std::fprintf(stderr, "lost or duplicated items: count %llu/%llu sum %llu/%llu\n",
+                static_cast<unsigned long long>(r.count),
+                static_cast<unsigned long long>(items),
+                static_cast<unsigned long long>(r.sum),
+                static_cast<unsigned long long>(expected));
+        std::abort();
+    }
+}
+
+// producers push_back disjoint value ranges, consumers pop_front until every
+// item has been seen.
+template <typename Queue>
+result mpmc(unsigned producers, unsigned consumers, std::uint64_t items)
+{
+    Queue q;
+    std::atomic<std::uint64_t> sum{0}, count{0};
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned p = 0; p < producers; ++p)
+        threads.emplace_back([&, p] {
+            for (auto i = items * p / producers; i < items * (p + 1) / producers; ++i)
+                q.push_back(i);
+        });
+    for (unsigned c = 0; c < consumers; ++c)
+        threads.emplace_back([&] {
+            std::uint64_t v, s = 0;
+            while (count.load(std::memory_order_relaxed) < items)
+            {
+                if (q.try_pop_front(v))
+                {
+                    s += v;
+                    count.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            sum += s;
+        });
+    for (auto& t : threads)
+        t.join();
+    auto stop = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> d = stop - start;
+    return {2 * items / d.count() / 1e6, sum.load(), count.load()};
+}
+
+// One owner pushes and pops at the back, thieves steal at the front.
+template <typename Queue>
+result owner_thieves(unsigned thieves, std::uint64_t items)
+{
+    Queue q;
+    std::atomic<std::uint64_t> sum{0}, count{0};
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    threads.emplace_back([&] {
+        std::uint64_t v, s = 0;
+        for (std::uint64_t i = 0; i < items; ++i)
+        {
+            q.push_back(i);
+            if (i % 2 && q.try_pop_back(v))
+            {
+                s += v;
+                count.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        while (q.try_pop_back(v))
+        {
+            s += v;
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+        sum += s;
+    });
+    for (unsigned t = 0; t < thieves; ++t)
+        threads.emplace_back([&] {
+            std::uint64_t v, s = 0;
+            while (count.load(std::memory_order_relaxed) < items)
+            {
+                if (q.try_pop_front(v))
+                {
+                    s += v;
+                    count.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            sum += s;
+        });
+    for (auto& t : threads)
+        t.join();
+    auto stop = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> d = stop - start;
+    return {2 * items / d.count() / 1e6, sum.load(), count.load()};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::uint64_t items = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    unsigned max_threads = argc > 2 ? std::atoi(argv[2]) : 8;
+
+    using concurrent = dllist_concurrent<std::uint64_t>;
+
+    std::printf("%-14s %8s %14s %14s\n", "scenario", "threads", "locked Mops/s", "concurrent Mops/s");
+    for (unsigned t = 1; t <= max_threads; t *= 2)
+    {
+        auto a = mpmc<locked_dllist>(t, t, items);
+        auto b = mpmc<concurrent>(t, t, items);
+        check(a, items);
+        check(b, items);
+        std::printf("%-14s %8u %14.2f %14.2f\n", "mpmc", 2 * t, a.mops, b.mops);
+    }
+    for (unsigned t = 1; t <= max_threads; t *= 2)
+    {
+        auto a = owner_thieves<locked_dllist>(t, items);
+        auto b = owner_thieves<concurrent>(t, items);
+        check(a, items);
+        check(b, items);
+        std::printf("%-14s %8u %14.2f %14.2f\n", "owner+thieves", t + 1, a.mops, b.mops);
+    }
+}
@@ -0,0 +1,238 @@
+// Container benchmark: dllist vs std::list vs std::deque.
+//
+//   g++ -std=c++17 -O2 -I.. dllist_bench.cpp -o dllist_bench
+//   ./dllist_bench [max_elements] [elements_per_measurement]
+//
+// Sweeps element sizes (8, 32, 128 bytes) and list lengths (powers of ten
+// from 100 to max_elements) over push/pop at both ends, insert/erase in the
+// middle through an iterator, forward and reverse iteration, copy, copy
+// assignment and clear(). Times are ns per element (per operation for the
+// middle insert/erase). bytes/elem is the heap footprint of a list built
+// by push_back, plus the container object itself, divided by its length,
+// measured through a counting allocator.
+//
+// Built with -DDLLIST_ENABLE_STATS, dllist rows also show node allocations,
+// frees, link rewrites and traversal steps per element.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iterator>
+#include <list>
+
+#include "../dllist.hxx"
+
+namespace {
+
+std::size_t live_bytes = 0;
+
+template <typename T>
+class counting_allocator
+{
+    public:
+        using value_type = T;
+
+        counting_allocator() = default;
+
+        template <typename U>
+        counting_allocator(counting_allocator<U> const&) noexcept
+        {}
+
+        T* allocate(std::size_t n)
+        {
+            live_bytes += n * sizeof(T);
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            live_bytes -= n * sizeof(T);
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template <typename U>
+        bool operator ==(counting_allocator<U> const&) const noexcept
+        {
+            return true;
+        }
+
+        template <typename U>
+        bool operator !=(counting_allocator<U> const&) const noexcept
+        {
+            return false;
+        }
+};
+
+template <std::size_t Size>
+struct element
+{
+    std::uint64_t words[Size / sizeof(std::uint64_t)];
+
+    explicit element(std::uint64_t v = 0) :
+        words{v}
+    {}
+};
+
+template <std::size_t Size>
+using dllist_type = dllist<element<Size>, counting_allocator<element<Size>>>;
+template <std::size_t Size>
+using list_type = std::list<element<Size>, counting_allocator<element<Size>>>;
+template <std::size_t Size>
+using deque_type = std::deque<element<Size>, counting_allocator<element<Size>>>;
+
+std::uint64_t sink = 0;
+
+// Runs setup() and then times f(), which performs `ops` operations, `reps`
+// times, and prints one row. Only f() is timed and counted.
+template <typename Setup, typename F>
+void measure(char const* container, std::size_t size, std::size_t n,
+        char const* op, std::size_t ops, std::size_t reps, Setup setup, F f)
+{
+    std::chrono::duration<double, std::nano> d{0};
+    dllist_stats delta{};
+    for (std::size_t r = 0; r < reps; ++r)
+    {
+        setup();
+        auto before = dllist_stats_snapshot();
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto stop = std::chrono::steady_clock::now();
+        auto after = dllist_stats_snapshot();
+
+        d += stop - start;
+        delta.node_allocs += after.node_allocs - before.node_allocs;
+        delta.node_frees += after.node_frees - before.node_frees;
+        delta.link_rewrites += after.link_rewrites - before.link_rewrites;
+        delta.traversal_steps += after.traversal_steps - before.traversal_steps;
+    }
+
+    auto total = static_cast<double>(ops) * static_cast<double>(reps);
+    std::printf("%-10s %5zu %9zu  %-12s %10.3f", container, size, n, op, d.count() / total);
+#ifdef DLLIST_ENABLE_STATS
+    std::printf(" %9.3f %9.3f %9.3f %9.3f",
+            static_cast<double>(delta.node_allocs) / total,
+            static_cast<double>(delta.node_frees) / total,
+            static_cast<double>(delta.link_rewrites) / total,
+            static_cast<double>(delta.traversal_steps) / total);
+#endif
+    std::printf("\n");
+}
+
+void no_setup()
+{}
+
+template <typename C>
+C build(std::size_t n)
+{
+    C c;
+    for (std::size_t i = 0; i < n; ++i)
+        c.push_back(typename C::value_type{i});
+    return c;
+}
+
+template <typename C, std::size_t Size>
+void run(char const* name, std::size_t n, std::size_t target)
+{
+    auto reps = target / n ? target / n : 1;
+
+    measure(name, Size, n, "push_back", n, reps, no_setup, [&] {
+        C c;
+        for (std::size_t i = 0; i < n; ++i)
+            c.push_back(typename C::value_type{i});
+        sink += c.size();
+    });
+    measure(name, Size, n, "push_front", n, reps, no_setup, [&] {
+        C c;
+        for (std::size_t i = 0; i < n; ++i)
+            c.push_front(typename C::value_type{i});
+        sink += c.size();
+    });
+
+    auto base = live_bytes;
+    auto c = build<C>(n);
+    auto bytes = static_cast<double>(live_bytes - base + sizeof(C)) / static_cast<double>(n);
+
+    C d;
+    auto refill = [&] { d = c; };
+    measure(name, Size, n, "pop_back", n, reps, refill, [&] {
+        for (std::size_t i = 0; i < n; ++i)
+            d.pop_back();
+    });
+    measure(name, Size, n, "pop_front", n, reps, refill, [&] {
+        for (std::size_t i = 0; i < n; ++i)
+            d.pop_front();
+    });
+
+    // Insert k elements in the middle through one iterator, then erase k.
+    // Finding the middle is untimed: deque iterators do not survive a round.
+    auto k = n / 2 < 256 ? n / 2 : std::size_t{256};
+    auto mid = c.begin();
+    auto find_mid = [&] { mid = std::next(c.begin(), static_cast<std::ptrdiff_t>(n / 2)); };
+    measure(name, Size, n, "mid_insert", 2 * k, reps, find_mid, [&] {
+        auto it = mid;
+        for (std::size_t i = 0; i < k; ++i)
+            it = c.insert(it, typename C::value_type{i});
+        for (std::size_t i = 0; i < k; ++i)
+            it = c.erase(it);
+    });
+
+    measure(name, Size, n, "iterate", n, reps, no_setup, [&] {
+        for (auto it = c.cbegin(); it != c.cend(); ++it)
+            sink += it->words[0];
+    });
+    measure(name, Size, n, "iterate_rev", n, reps, no_setup, [&] {
+        for (auto it = c.crbegin(); it != c.crend(); ++it)
+            sink += it->words[0];
+    });
+
+    measure(name, Size, n, "copy", n, reps, no_setup, [&] {
+        C e{c};
+        sink += e.size();
+    });
+    measure(name, Size, n, "assign", n, reps, [&] { d = build<C>(n / 2); }, [&] {
+        d = c;
+        sink += d.size();
+    });
+    measure(name, Size, n, "clear", n, reps, refill, [&] {
+        d.clear();
+        sink += d.size();
+    });
+
+    std::printf("%-10s %5zu %9zu  %-12s %10.1f\n", name, Size, n, "bytes/elem", bytes);
+}
+
+template <std::size_t Size>
+void run_size(std::size_t max_n, std::size_t target)
+{
+    for (std::size_t n = 100; n <= max_n; n *= 10)
+    {
+        run<dllist_type<Size>, Size>("dllist", n, target);
+        run<list_type<Size>, Size>("std::list", n, target);
+        run<deque_type<Size>, Size>("std::deque", n, target);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::size_t max_n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    std::size_t target = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+
+    std::printf("%-10s %5s %9s  %-12s %10s", "container", "size", "elements", "op", "ns/op");
+#ifdef DLLIST_ENABLE_STATS
+    std::printf(" %9s %9s %9s %9s", "allocs", "frees", "links", "steps");
+#endif
+    std::printf("\n");
+
+    run_size<8>(max_n, target);
+    run_size<32>(max_n, target);
+    run_size<128>(max_n, target);
+
+    // Keep the measured loops observable.
+    if (sink == 42)
+        std::puts("");
+}
@@ -0,0 +1,61 @@
+// Iteration microbenchmark: dllist traversal cost per link policy.
+//
+//   g++ -std=c++20 -O2 -I.. xorptr_traits_bench.cpp -o xorptr_traits_bench
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "../dllist.hxx"
+
+namespace {
+
+template <template <typename> class LinkTraits>
+using list_type = dllist<std::uint64_t, std::allocator<std::uint64_t>, LinkTraits>;
+
+template <typename List, typename Iter>
+double ns_per_step(List const& l, Iter first, Iter last, int reps)
+{
+    std::uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r)
+        for (auto i = first; i != last; ++i)
+            sum += *i;
+    auto stop = std::chrono::steady_clock::now();
+
+    // Keep the loop observable.
+    if (sum == 42)
+        std::puts("");
+
+    std::chrono::duration<double, std::nano> d = stop - start;
+    return d.count() / (static_cast<double>(l.size()) * reps);
+}
+
+template <template <typename> class LinkTraits>
+void run(char const* name, std::size_t n, int reps)
+{
+    list_type<LinkTraits> l;
+    for (std::size_t i = 0; i < n; ++i)
+        l.push_back(i);
+
+    auto fwd = ns_per_step(l, l.cbegin(), l.cend(), reps);
+    auto rev = ns_per_step(l, l.crbegin(), l.crend(), reps);
+
+    std::printf("%-10s %10zu %12.3f %12.3f\n", name, n, fwd, rev);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+    int reps = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+    std::printf("%-10s %10s %12s %12s\n",
+            "policy", "elements", "fwd ns/elem", "rev ns/elem");
+    run<xorptr_bytewise_traits>("bytewise", n, reps);
+    run<xorptr_traits>("uintptr", n, reps);
+}
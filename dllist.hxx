@@ -1,31 +1,44 @@
-#define CXX_XOR_PROJECT_USE_REINTERPRET_CAST
 #ifndef DLLIST_HXX
 #define DLLIST_HXX
 
 #include <algorithm>
+#include <cassert>
+#include <functional>
 #include <iterator>
 #include <limits>
 #include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
+#include "dllist_stats.hxx"
 #include "xorptr.hxx"
 
-template <typename T>
+template <typename T, template <typename> class LinkTraits = xorptr_traits>
+class dllist_node_ptr_only; // doubly-linked list link-only (sentinel) node type
+
+template <typename T, template <typename> class LinkTraits = xorptr_traits>
 class dllist_node;      // doubly-linked list node type
 
-template <typename T>
+template <
+    typename T,
+    typename Alloc = std::allocator<T>,
+    template <typename> class LinkTraits = xorptr_traits
+    >
 class dllist;           // doubly-linked list container type
 
-template <typename T>
+template <typename T, template <typename> class LinkTraits = xorptr_traits>
 class dllist_iter;      // doubly-linked list iterator type
 
-template <typename T>
+template <typename T, template <typename> class LinkTraits = xorptr_traits>
 class dllist_citer;     // doubly-linked list const_iterator type
 
-template <typename T>
+template <typename T, template <typename> class LinkTraits>
 class dllist_node_ptr_only
 {
     public:
-        using xorptr_type = xorptr<dllist_node_ptr_only>;
+        using xorptr_type = xorptr<dllist_node_ptr_only, LinkTraits>;
 
     private:
         xorptr_type xorptr_;
@@ -46,10 +59,10 @@ class dllist_node_ptr_only
             xorptr_{prev,next}
         {}
 
-        explicit dllist_node_ptr_only(xorptr<dllist_node_ptr_only> const& xp):
+        explicit dllist_node_ptr_only(xorptr_type const& xp):
             xorptr_{xp}
         {}
-        explicit dllist_node_ptr_only(xorptr<dllist_node_ptr_only>&& xp):
+        explicit dllist_node_ptr_only(xorptr_type&& xp):
             xorptr_{std::move(xp)}
         {}
 
@@ -58,19 +71,19 @@ class dllist_node_ptr_only
             std::swap(xorptr_, b.xorptr_);
         }
 
-        dllist_node<T>& to_node() &
+        dllist_node<T, LinkTraits>& to_node() &
         {
-            return static_cast<dllist_node<T>&>(*this);
+            return static_cast<dllist_node<T, LinkTraits>&>(*this);
         }
 
-        dllist_node<T> const& to_node() const&
+        dllist_node<T, LinkTraits> const& to_node() const&
         {
-            return static_cast<dllist_node<T> const&>(*this);
+            return static_cast<dllist_node<T, LinkTraits> const&>(*this);
         }
 
-        dllist_node<T>&& to_node() &&
+        dllist_node<T, LinkTraits>&& to_node() &&
         {
-            return static_cast<dllist_node<T>&&>(*this);
+            return static_cast<dllist_node<T, LinkTraits>&&>(*this);
         }
 
         dllist_node_ptr_only* nextptr(dllist_node_ptr_only* prev)
@@ -88,11 +101,13 @@ class dllist_node_ptr_only
                 dllist_node_ptr_only* newptr
                 )
         {
+            DLLIST_STATS(link_rewrites);
             xorptr_ = xorptr_type{ xorptr_ ^ oldptr, newptr };
         }
 
         void setptr(dllist_node_ptr_only* ptr1, dllist_node_ptr_only* ptr2)
         {
+            DLLIST_STATS(link_rewrites);
             xorptr_ = xorptr_type{ ptr1, ptr2 };
         }
 
@@ -108,6 +123,7 @@ class dllist_node_ptr_only
 
             before->updateptr(oldnext, new_node);
 
+            DLLIST_STATS(link_rewrites);
             new_node->xorptr_ = xorptr_type{ before, oldnext };
 
             return oldnext;
@@ -126,71 +142,78 @@ class dllist_node_ptr_only
 
             before->updateptr(oldnext, newnext);
 
+            DLLIST_STATS(link_rewrites);
             oldnext->xorptr_ = xorptr_type{};
 
             return oldnext;
         }
 };
 
-template <typename T>
-class dllist_node final : public dllist_node_ptr_only<T>
+template <typename T, template <typename> class LinkTraits>
+class dllist_node final : public dllist_node_ptr_only<T, LinkTraits>
 {
     T datum_;
     public:
-    using xorptr_type = typename dllist_node_ptr_only<T>::xorptr_type;
+    using xorptr_type = typename dllist_node_ptr_only<T, LinkTraits>::xorptr_type;
 
     ~dllist_node() = default;
 
     explicit dllist_node(T const& datum):
-        dllist_node_ptr_only<T>(nullptr,nullptr),
+        dllist_node_ptr_only<T, LinkTraits>(nullptr,nullptr),
         datum_{datum}
     {}
 
     explicit dllist_node(T&& datum):
-        dllist_node_ptr_only<T>(nullptr,nullptr),
+        dllist_node_ptr_only<T, LinkTraits>(nullptr,nullptr),
         datum_{std::move(datum)}
     {}
 
+    template <typename... Args>
+    explicit dllist_node(std::in_place_t, Args&&... args):
+        dllist_node_ptr_only<T, LinkTraits>(nullptr,nullptr),
+        datum_(std::forward<Args>(args)...)
+    {}
+
     dllist_node(T const& datum, dllist_node* prev, dllist_node* next):
-        dllist_node_ptr_only<T>(prev,next),
+        dllist_node_ptr_only<T, LinkTraits>(prev,next),
         datum_{datum}
     {}
 
     dllist_node(T&& datum, dllist_node* prev, dllist_node* next):
-        dllist_node_ptr_only<T>(prev,next),
+        dllist_node_ptr_only<T, LinkTraits>(prev,next),
         datum_{std::move(datum)}
     {}
 
     dllist_node(T const& datum, xorptr_type const& xp):
-        dllist_node_ptr_only<T>(xp),
+        dllist_node_ptr_only<T, LinkTraits>(xp),
         datum_{datum}
     {}
 
     dllist_node(T&& datum, xorptr_type const& xp):
-        dllist_node_ptr_only<T>(xp),
+        dllist_node_ptr_only<T, LinkTraits>(xp),
         datum_{std::move(datum)}
     {}
 
     dllist_node(T&& datum, xorptr_type&& xp):
-        dllist_node_ptr_only<T>{std::move(xp)},
+        dllist_node_ptr_only<T, LinkTraits>{std::move(xp)},
         datum_{std::move(datum)}
     {}
 
     dllist_node(dllist_node&& n):
-        dllist_node_ptr_only<T>(std::move(n)),
+        dllist_node_ptr_only<T, LinkTraits>(std::move(n)),
         datum_{std::move(n.datum_)}
     {}
 
     dllist_node& operator =(dllist_node&& n)
     {
-        dllist_node_ptr_only<T>::operator =( std::move(n) );
+        dllist_node_ptr_only<T, LinkTraits>::operator =( std::move(n) );
         datum_ = std::move(n.datum_);
         return *this;
     }
 
     void swap(dllist_node& b)
     {
-        dllist_node_ptr_only<T>::swap(static_cast<dllist_node_ptr_only<T>>(b));
+        dllist_node_ptr_only<T, LinkTraits>::swap(static_cast<dllist_node_ptr_only<T, LinkTraits>>(b));
         std::swap(datum_, b.datum_);
         swap(datum_, b.datum_);
     }
@@ -208,30 +231,410 @@ class dllist_node final : public dllist_node_ptr_only<T>
 
 //===========================================================================
 
-template <typename T>
-inline void swap(dllist_node_ptr_only<T>& a, dllist_node_ptr_only<T>& b)
+template <typename T, template <typename> class L>
+inline void swap(dllist_node_ptr_only<T, L>& a, dllist_node_ptr_only<T, L>& b)
 {
     a.swap(b);
 }
 
-    template <typename T>
-inline void swap(dllist_node<T>& a, dllist_node<T>& b)
+    template <typename T, template <typename> class L>
+inline void swap(dllist_node<T, L>& a, dllist_node<T, L>& b)
 {
     a.swap(b);
 }
 
 //===========================================================================
 
-template <typename T>
+template <typename T, typename Alloc, template <typename> class LinkTraits>
 class dllist
 {
+    static_assert(!xorptr_needs_window<LinkTraits>::value
+            || allocator_uses_window<Alloc>::value,
+            "this link policy needs an allocator drawing from one 4 GiB window");
+
     private:
+        using node_allocator_type =
+            typename std::allocator_traits<Alloc>::template rebind_alloc<dllist_node<T, LinkTraits>>;
+        using node_alloc_traits = std::allocator_traits<node_allocator_type>;
+
+        // Policies such as xorptr_offset32_traits need every node a link can
+        // refer to in the allocator's storage, so their sentinels come from
+        // the allocator too. Otherwise they are embedded in the list.
+        static constexpr bool allocated_sentinels =
+            xorptr_needs_allocated_sentinels<LinkTraits>::value;
+
+        using sentinel_allocator_type =
+            typename std::allocator_traits<Alloc>::template rebind_alloc<
+                dllist_node_ptr_only<T, LinkTraits>
+                >;
+        using sentinel_alloc_traits = std::allocator_traits<sentinel_allocator_type>;
+
         std::size_t size_;
-        dllist_node_ptr_only<T> front_;
-        dllist_node_ptr_only<T> back_;
+        dllist_node_ptr_only<T, LinkTraits>* front_;
+        dllist_node_ptr_only<T, LinkTraits>* back_;
+        dllist_node_ptr_only<T, LinkTraits> sentinels_[2];  // unused if allocated
+        node_allocator_type alloc_;
+
+        // Optional sparse index: checkpoints_[k] is an iterator to element
+        // k * index_stride_ + index_offset_, with index_offset_ below the
+        // stride. Built lazily by iterator_at(). Inserts and erases at
+        // either end keep it valid; any other modification discards it.
+        // At the front, a checkpoint is added or dropped once per stride
+        // elements, shifting the others.
+        std::size_t index_stride_;
+        std::size_t index_offset_;
+        mutable std::vector<dllist_iter<T, LinkTraits>> checkpoints_;
+
+        void invalidate_index() noexcept
+        {
+            checkpoints_.clear();
+            index_offset_ = 0;
+        }
+
+        void trim_index() noexcept
+        {
+            if (index_stride_ == 0)
+                return;
+            auto n = size_ > index_offset_
+                ? (size_ - index_offset_ + index_stride_ - 1) / index_stride_
+                : 0;
+            if (checkpoints_.size() > n)
+                checkpoints_.erase(checkpoints_.begin() + n, checkpoints_.end());
+        }
+
+        // Call after node was inserted as the first element.
+        void index_pushed_front(dllist_node_ptr_only<T, LinkTraits>* node) noexcept
+        {
+            if (checkpoints_.empty())
+                return;
+            auto& first = checkpoints_.front();
+            if (first.prevptr_ == front_)
+                first.prevptr_ = node;
+            if (++index_offset_ == index_stride_)
+            {
+                try {
+                    checkpoints_.insert(checkpoints_.begin(), begin());
+                    index_offset_ = 0;
+                } catch(...) {
+                    invalidate_index();
+                }
+            }
+        }
+
+        // Call after node, the first element, was removed.
+        void index_popped_front(dllist_node_ptr_only<T, LinkTraits>* node) noexcept
+        {
+            if (checkpoints_.empty())
+                return;
+            if (index_offset_ == 0)
+            {
+                checkpoints_.erase(checkpoints_.begin());
+                index_offset_ = index_stride_;
+                if (checkpoints_.empty())
+                    return;
+            }
+            --index_offset_;
+            auto& first = checkpoints_.front();
+            if (first.prevptr_ == node)
+                first.prevptr_ = front_;
+        }
+
+        // Call after a node away from the front was inserted or removed
+        // before y. Only changes at the back keep the index.
+        void index_changed_before(dllist_node_ptr_only<T, LinkTraits>* y) noexcept
+        {
+            if (y == back_)
+                trim_index();
+            else
+                invalidate_index();
+        }
+
+        template <typename... Args>
+        dllist_node<T, LinkTraits>* new_node(Args&&... args)
+        {
+            auto p = node_alloc_traits::allocate(alloc_, 1);
+            try {
+                node_alloc_traits::construct(alloc_, p, std::forward<Args>(args)...);
+            } catch(...) {
+                node_alloc_traits::deallocate(alloc_, p, 1);
+                throw;
+            }
+            DLLIST_STATS(node_allocs);
+            return p;
+        }
+
+        void delete_node(dllist_node_ptr_only<T, LinkTraits>* p)
+        {
+            DLLIST_STATS(node_frees);
+            auto n = &p->to_node();
+            node_alloc_traits::destroy(alloc_, n);
+            node_alloc_traits::deallocate(alloc_, n, 1);
+        }
+
+        void new_sentinels() noexcept(!allocated_sentinels)
+        {
+            if constexpr (!allocated_sentinels)
+            {
+                front_ = &sentinels_[0];
+                back_ = &sentinels_[1];
+                front_->setptr(back_, back_);
+                back_->setptr(front_, front_);
+            }
+            else
+            {
+                sentinel_allocator_type a{alloc_};
+                front_ = sentinel_alloc_traits::allocate(a, 1);
+                try {
+                    back_ = sentinel_alloc_traits::allocate(a, 1);
+                } catch(...) {
+                    sentinel_alloc_traits::deallocate(a, front_, 1);
+                    throw;
+                }
+                sentinel_alloc_traits::construct(a, front_, back_, back_);
+                sentinel_alloc_traits::construct(a, back_, front_, front_);
+            }
+        }
+
+        void delete_sentinels()
+        {
+            if constexpr (allocated_sentinels)
+            {
+                sentinel_allocator_type a{alloc_};
+                for (auto p : { front_, back_ })
+                {
+                    sentinel_alloc_traits::destroy(a, p);
+                    sentinel_alloc_traits::deallocate(a, p, 1);
+                }
+            }
+        }
+
+        using node_ptr = dllist_node_ptr_only<T, LinkTraits>*;
+
+        // Exchanges the nodes and sizes of two lists whose allocators are
+        // equal. Allocated sentinels travel with their nodes; embedded ones
+        // stay put and the end nodes of each chain are relinked instead.
+        void swap_nodes(dllist& l) noexcept
+        {
+            std::swap(size_, l.size_);
+            if constexpr (allocated_sentinels)
+            {
+                std::swap(front_, l.front_);
+                std::swap(back_, l.back_);
+            }
+            else
+                relink_swap(l);
+        }
+
+        // Takes the elements and allocator of tmp, which was built for
+        // this list by an assignment, and leaves it the old ones to free.
+        // The index setting stays this list's own.
+        void replace_with(dllist& tmp) noexcept
+        {
+            swap_nodes(tmp);
+            std::swap(alloc_, tmp.alloc_);
+            invalidate_index();
+        }
+
+        void relink_swap(dllist& l) noexcept
+        {
+            auto h1 = front_->nextptr(back_);
+            auto t1 = back_->nextptr(front_);
+            auto h2 = l.front_->nextptr(l.back_);
+            auto t2 = l.back_->nextptr(l.front_);
+
+            if (h1 != back_)
+            {
+                h1->updateptr(front_, l.front_);
+                t1->updateptr(back_, l.back_);
+            }
+            if (h2 != l.back_)
+            {
+                h2->updateptr(l.front_, front_);
+                t2->updateptr(l.back_, back_);
+            }
+
+            front_->setptr(back_, h2 != l.back_ ? h2 : back_);
+            back_->setptr(front_, h2 != l.back_ ? t2 : front_);
+            l.front_->setptr(l.back_, h1 != back_ ? h1 : l.back_);
+            l.back_->setptr(l.front_, h1 != back_ ? t1 : l.front_);
+        }
+
+        // Moves the chain a..b, currently between p and q, to between the
+        // adjacent nodes x and y. The chain's interior links are untouched.
+        static void transfer(
+                node_ptr x, node_ptr y,
+                node_ptr p, node_ptr a, node_ptr b, node_ptr q
+                )
+        {
+            p->updateptr(a, q);
+            q->updateptr(b, p);
+            x->updateptr(y, a);
+            y->updateptr(x, b);
+            a->updateptr(p, x);
+            b->updateptr(q, y);
+        }
+
+        // Unlinks node without destroying it, returning its successor.
+        node_ptr detach(node_ptr prev, node_ptr node)
+        {
+            auto next = node->nextptr(prev);
+            prev->updateptr(node, next);
+            next->updateptr(node, prev);
+            size_--;
+            invalidate_index();
+            return next;
+        }
+
+        // Unlinks and destroys node, returning its successor.
+        node_ptr unlink(node_ptr prev, node_ptr node)
+        {
+            auto next = detach(prev, node);
+            delete_node(node);
+            return next;
+        }
+
+        // sort() and merge() temporarily thread nodes into singly-linked
+        // chains by storing setptr(next, key), so no extra storage is
+        // needed. key is a sentinel (always a valid address for the link
+        // policy) and doubles as the chain terminator.
+        node_ptr detach_chain(node_ptr key)
+        {
+            invalidate_index();
+            if (empty())
+                return key;
+
+            auto head = front_->nextptr(back_);
+            auto prev = front_;
+            auto cur = head;
+            while (cur != back_)
+            {
+                DLLIST_STATS(traversal_steps);
+                auto next = cur->nextptr(prev);
+                prev = cur;
+                cur->setptr(next == back_ ? key : next, key);
+                cur = next;
+            }
+
+            front_->setptr(back_, back_);
+            back_->setptr(front_, front_);
+            return head;
+        }
+
+        void attach_chain(node_ptr head, node_ptr key)
+        {
+            auto prev = front_;
+            for (auto cur = head; cur != key; )
+            {
+                DLLIST_STATS(traversal_steps);
+                auto next = cur->nextptr(key);
+                cur->setptr(prev, next == key ? back_ : next);
+                prev = cur;
+                cur = next;
+            }
+            front_->setptr(back_, head == key ? back_ : head);
+            back_->setptr(front_, prev);
+        }
+
+        // Destroys the nodes from node up to (not including) end, walking
+        // away from prev, and returns how many there were. Links are read
+        // but never rewritten.
+        std::size_t delete_chain(node_ptr prev, node_ptr node, node_ptr end)
+        {
+            std::size_t n = 0;
+            for (; node != end; ++n)
+            {
+                DLLIST_STATS(traversal_steps);
+                auto next = node->nextptr(prev);
+                prev = node;
+                delete_node(node);
+                node = next;
+            }
+            return n;
+        }
+
+        // Builds the nodes returned by make() (until it returns nullptr)
+        // into a chain whose ends already point at the adjacent nodes x and
+        // y, then stitches it in with two link updates. If make() throws,
+        // the list is left untouched.
+        template <typename Make>
+        void link_new_nodes(node_ptr x, node_ptr y, Make make)
+        {
+            node_ptr head = nullptr;
+            node_ptr tail = x;
+            std::size_t n = 0;
+            try {
+                while (auto node = make())
+                {
+                    node->setptr(tail, y);
+                    if (tail != x)
+                        tail->updateptr(y, node);
+                    else
+                        head = node;
+                    tail = node;
+                    ++n;
+                }
+            } catch(...) {
+                if (head)
+                    delete_chain(x, head, y);
+                throw;
+            }
+
+            if (!head)
+                return;
+            x->updateptr(y, head);
+            y->updateptr(x, tail);
+            size_ += n;
+            index_changed_before(y);
+        }
+
+        template <typename InIter>
+        void link_new_nodes(node_ptr x, node_ptr y, InIter first, InIter const& last)
+        {
+            link_new_nodes(x, y, [&]() -> dllist_node<T, LinkTraits>* {
+                if (first == last)
+                    return nullptr;
+                auto node = new_node(std::in_place, *first);
+                ++first;
+                return node;
+            });
+        }
+
+        template <typename Compare>
+        static node_ptr merge_chains(node_ptr a, node_ptr b, node_ptr key, Compare& comp)
+        {
+            auto head = key;
+            auto tail = key;
+            auto append = [&](node_ptr n) {
+                if (head == key)
+                    head = n;
+                else
+                    tail->setptr(n, key);
+                tail = n;
+            };
+
+            while (a != key && b != key)
+            {
+                DLLIST_STATS(traversal_steps);
+                if (comp(b->to_node().datum(), a->to_node().datum()))
+                {
+                    auto next = b->nextptr(key);
+                    append(b);
+                    b = next;
+                }
+                else
+                {
+                    auto next = a->nextptr(key);
+                    append(a);
+                    a = next;
+                }
+            }
+            append(a != key ? a : b);
+            return head;
+        }
 
     public:
         using value_type = T;
+        using allocator_type = Alloc;
 
         using reference = value_type&;
         using const_reference = value_type const&;
@@ -239,8 +642,8 @@ class dllist
         using pointer = value_type*;
         using const_pointer = value_type const*;
 
-        using iterator = dllist_iter<T>;
-        using const_iterator = dllist_citer<T>;
+        using iterator = dllist_iter<T, LinkTraits>;
+        using const_iterator = dllist_citer<T, LinkTraits>;
 
         using reverse_iterator = std::reverse_iterator<iterator>;
         using const_reverse_iterator = std::reverse_iterator<const_iterator>;
@@ -248,77 +651,124 @@ class dllist
         using size_type = std::size_t;
         using difference_type = std::ptrdiff_t;
 
-        dllist():
-            size_{},
-            front_{&back_, &back_},
-            back_{&front_, &front_}
+        dllist() noexcept(noexcept(Alloc{}) && !allocated_sentinels):
+            dllist{Alloc{}}
         {}
 
-        dllist(size_type n, T const& value = T{}):
-            dllist<T>{}
+        explicit dllist(Alloc const& alloc) noexcept(!allocated_sentinels):
+            size_{},
+            sentinels_{
+                dllist_node_ptr_only<T, LinkTraits>{nullptr, nullptr},
+                dllist_node_ptr_only<T, LinkTraits>{nullptr, nullptr}
+            },
+            alloc_{alloc},
+            index_stride_{},
+            index_offset_{}
+        {
+            new_sentinels();
+        }
+
+        dllist(size_type n, T const& value = T{}, Alloc const& alloc = Alloc{}):
+            dllist{alloc}
         {
-            std::fill_n(std::back_inserter(*this), n, value);
+            link_new_nodes(front_, back_, [&]() -> dllist_node<T, LinkTraits>* {
+                return n-- ? new_node(value) : nullptr;
+            });
         }
 
-dllist(std::initializer_list<T> il):
-    dllist<T>{}
+dllist(std::initializer_list<T> il, Alloc const& alloc = Alloc{}):
+    dllist{alloc}
 {
-    std::copy(il.begin(), il.end(), std::back_inserter(*this));
+    link_new_nodes(front_, back_, il.begin(), il.end());
 }
 
 template <typename InIter>
-dllist(InIter const& first, InIter const& last):
-    dllist<T>{}
+dllist(InIter const& first, InIter const& last, Alloc const& alloc = Alloc{}):
+    dllist{alloc}
 {
-    std::copy(first, last, std::back_inserter(*this));
+    link_new_nodes(front_, back_, first, last);
 }
 
 dllist(dllist const& l):
-    dllist<T>{}
+    dllist{l, node_alloc_traits::select_on_container_copy_construction(l.alloc_)}
+{
+}
+
+dllist(dllist const& l, Alloc const& alloc):
+    dllist{alloc}
 {
-    std::copy(l.begin(), l.end(), std::back_inserter(*this));
+    index_stride_ = l.index_stride_;
+    link_new_nodes(front_, back_, l.begin(), l.end());
 }
 
-dllist(dllist&& l) :
-    dllist<T>{}
+dllist(dllist&& l) noexcept(!allocated_sentinels) :
+    dllist{l.alloc_}
 {
-    swap(l);
+    swap_nodes(l);
+    std::swap(index_stride_, l.index_stride_);
+    l.invalidate_index();
 }
 
 ~dllist() {
-    while(!empty()) {
-        try {
-            clear();
-        } catch(...) {}
-    }
+    clear();
+    delete_sentinels();
 }
 
 dllist& operator =(dllist const& l) {
-    dllist<T> tmp{l};
-    this->swap(tmp);
+    dllist tmp{l,
+        node_alloc_traits::propagate_on_container_copy_assignment::value
+            ? l.alloc_ : alloc_};
+    replace_with(tmp);
     return *this;
 }
 
-dllist& operator =(dllist&& l) {
-    dllist<T> tmp{std::move(l)};
-    this->swap(tmp);
+// Without allocator propagation, nodes are only taken over from a list with
+// an equal allocator; otherwise the elements are moved one by one.
+dllist& operator =(dllist&& l) noexcept(
+        (node_alloc_traits::propagate_on_container_move_assignment::value
+         || node_alloc_traits::is_always_equal::value)
+        && !allocated_sentinels) {
+    if constexpr (node_alloc_traits::propagate_on_container_move_assignment::value)
+    {
+        dllist tmp{std::move(l)};
+        replace_with(tmp);
+    }
+    else
+    {
+        dllist tmp{alloc_};
+        if (alloc_ == l.alloc_)
+        {
+            tmp.swap_nodes(l);
+            l.invalidate_index();
+        }
+        else
+            tmp.link_new_nodes(tmp.front_, tmp.back_,
+                    std::make_move_iterator(l.begin()),
+                    std::make_move_iterator(l.end()));
+        replace_with(tmp);
+    }
     return *this;
 }
 
 void assign(std::initializer_list<T> il) {
-    dllist<T> tmp{il};
-    this->swap(tmp);
+    dllist tmp{il, alloc_};
+    replace_with(tmp);
 }
 
 void assign(size_type n, value_type const& value) {
-    dllist<T> tmp(n,value);
-    this->swap(tmp);
+    dllist tmp(n,value,alloc_);
+    replace_with(tmp);
 }
 
 template <typename InIter>
 void assign(InIter const& first, InIter const& last) {
-    dllist<T> tmp(first,last);
-    this->swap(tmp);
+    dllist tmp(first,last,alloc_);
+    replace_with(tmp);
+}
+
+allocator_type get_allocator() const
+{
+    return allocator_type{alloc_};
 }
 
 bool empty() const
@@ -336,43 +786,119 @@ size_type max_size() const
     return std::numeric_limits<size_type>::max();
 }
 
+// Keeps a checkpoint every stride elements so that iterator_at()/at() cost
+// O(size() / stride + stride) instead of O(size()). A stride of 0 disables
+// the index.
+void enable_index(size_type stride)
+{
+    index_stride_ = stride;
+    invalidate_index();
+    if (stride == 0)
+        checkpoints_.shrink_to_fit();
+}
+
+void disable_index()
+{
+    enable_index(0);
+}
+
+size_type index_stride() const
+{
+    return index_stride_;
+}
+
+// Iterator to element i, for i <= size(). Walks from the nearest
+// checkpoint, or from the nearer end when the index is disabled.
+iterator iterator_at(size_type i)
+{
+    if (i >= size_)
+        return end();
+
+    auto from_back = size_ - i;
+    auto it = begin();
+    auto steps = i;
+
+    if (index_stride_ != 0)
+    {
+        if (checkpoints_.empty())
+        {
+            checkpoints_.push_back(begin());
+            index_offset_ = 0;
+        }
+        if (i >= index_offset_)
+        {
+            auto k = (i - index_offset_) / index_stride_;
+            while (checkpoints_.size() <= k)
+                checkpoints_.push_back(
+                        std::next(checkpoints_.back(), index_stride_));
+            it = checkpoints_[k];
+            steps = (i - index_offset_) % index_stride_;
+        }
+    }
+
+    if (from_back < steps)
+        return std::prev(end(), from_back);
+    return std::next(it, steps);
+}
+
+// Builds the index lazily, so concurrent calls on one list need external
+// synchronisation even though this overload is const.
+const_iterator iterator_at(size_type i) const
+{
+    return const_cast<dllist*>(this)->iterator_at(i);
+}
+
+reference at(size_type i)
+{
+    if (i >= size_)
+        throw std::out_of_range{"dllist::at"};
+    return *iterator_at(i);
+}
+
+const_reference at(size_type i) const
+{
+    if (i >= size_)
+        throw std::out_of_range{"dllist::at"};
+    return *iterator_at(i);
+}
+
 reference front()
 {
-    return front_.nextptr(&back_)->to_node().datum();
+    return front_->nextptr(back_)->to_node().datum();
 }
 
 const_reference front() const
 {
-    return front_.nextptr(&back_)->to_node().datum();
+    return front_->nextptr(back_)->to_node().datum();
 }
 
 reference back()
 {
-    return back_.nextptr(&front_)->to_node().datum();
+    return back_->nextptr(front_)->to_node().datum();
 }
 
 const_reference back() const
 {
-    return back_.nextptr(&front_)->to_node().datum();
+    return back_->nextptr(front_)->to_node().datum();
 }
 
 iterator begin()
 {
-    return dllist_iter<T>{&front_, front_.nextptr(&back_)};
+    return dllist_iter<T, LinkTraits>{front_, front_->nextptr(back_)};
 }
 
 iterator end()
 {
-    return dllist_iter<T>(back_.nextptr(&front_), &back_);
+    return dllist_iter<T, LinkTraits>(back_->nextptr(front_), back_);
 }
 
 const_iterator begin() const
 {
-    return dllist_citer<T>(&front_, front_.nextptr(&back_));
+    return dllist_citer<T, LinkTraits>(front_, front_->nextptr(back_));
 }
 const_iterator end() const
 {
-    return dllist_citer<T>{back_.nextptr(&front_), &back_};
+    return dllist_citer<T, LinkTraits>{back_->nextptr(front_), back_};
 }
 const_iterator cbegin() const
 {
@@ -414,117 +940,81 @@ const_reverse_iterator crend() const
 
 void clear()
 {
-    while(!empty())
-        pop_back();
+    delete_chain(front_, front_->nextptr(back_), back_);
+    front_->setptr(back_, back_);
+    back_->setptr(front_, front_);
+    size_ = 0;
+    invalidate_index();
 }
 
+// Allocators are exchanged only if they propagate on swap; otherwise they
+// must compare equal.
 void swap(dllist& l)
 {
-    if (size_ == 0)
-    {
-        front_.setptr(&l.back_, &l.back_);
-        back_.setptr(&l.front_, &l.front_);
-    }
-    else if (size_ == 1)
-    {
-        auto element = front_.nextptr(&back_);
-
-        front_.setptr(&l.back_, element);
-        back_.setptr(element, &l.front_);
-
-        element->setptr(&l.back_, &l.front_);
-    }
-    else
-    {
-        auto first = front_.nextptr(&back_);
-        auto second = first->nextptr(&front_);
-        auto last = back_.nextptr(&front_);
-        auto before_last = last->nextptr(&back_);
-
-        front_.setptr(&l.back_, first);
-        back_.setptr(&l.front_, last);
-
-        first->setptr(&l.front_, second);
-        last->setptr(&l.back_, before_last);
-    }
-
-    if (l.size_ == 0)
-    {
-        l.front_.setptr(&back_, &back_);
-        l.back_.setptr(&front_, &front_);
-    }
-    else if (l.size_ == 1)
-    {
-        auto l_element = l.front_.nextptr(&l.back_);
-
-        l.front_.setptr(&back_, l_element);
-        l.back_.setptr(l_element, &front_);
-
-        l_element->setptr(&back_, &front_);
-    }
+    if constexpr (node_alloc_traits::propagate_on_container_swap::value)
+        std::swap(alloc_, l.alloc_);
     else
-    {
-        auto l_first = l.front_.nextptr(&l.back_);
-        auto l_second = l_first->nextptr(&l.front_);
-        auto l_last = l.back_.nextptr(&l.front_);
-        auto l_before_last = l_last->nextptr(&l.back_);
-
-        l.front_.setptr(&back_, l_first);
-        l.back_.setptr(&front_, l_last);
-
-        l_first->setptr(&front_, l_second);
-        l_last->setptr(&back_, l_before_last);
-    }
-
-    front_.swap(l.front_);
-    back_.swap(l.back_);
-
-    std::swap(size_, l.size_);
+        assert(alloc_ == l.alloc_ && "dllist::swap with unequal allocators");
+    swap_nodes(l);
+    std::swap(index_stride_, l.index_stride_);
+    // Checkpoints may hold the other list's embedded sentinels.
+    invalidate_index();
+    l.invalidate_index();
 }
 
 void push_front(value_type const& v)
 {
-    dllist_node<T>::insert(&back_, &front_, new dllist_node<T>(v));
+    auto node = new_node(v);
+    dllist_node<T, LinkTraits>::insert(back_, front_, node);
     size_++;
+    index_pushed_front(node);
 }
 
 void push_front(value_type&& v)
 {
-    dllist_node<T>::insert(&back_, &front_, new dllist_node<T>(std::move(v)));
+    auto node = new_node(std::move(v));
+    dllist_node<T, LinkTraits>::insert(back_, front_, node);
     size_++;
+    index_pushed_front(node);
 }
 
 void pop_front()
 {
-    auto old = dllist_node<T>::remove(&back_, &front_);
+    auto old = dllist_node<T, LinkTraits>::remove(back_, front_);
     size_--;
-    delete old;
+    index_popped_front(old);
+    delete_node(old);
 }
 
 void push_back(value_type const& v)
 {
-    dllist_node<T>::insert(&front_, &back_, new dllist_node<T>(v));
+    dllist_node<T, LinkTraits>::insert(front_, back_, new_node(v));
     size_++;
 }
 void push_back(value_type&& v)
 {
-    dllist_node<T>::insert(&front_, &back_, new dllist_node<T>(std::move(v)));
+    dllist_node<T, LinkTraits>::insert(front_, back_, new_node(std::move(v)));
     size_++;
 }
 void pop_back()
 {
-    auto old = dllist_node<T>::remove(&front_, &back_);
+    auto old = dllist_node<T, LinkTraits>::remove(front_, back_);
     size_--;
-    delete old;
+    delete_node(old);
+    trim_index();
 }
 
     template <typename... Args>
 iterator emplace(iterator pos, Args&&... args)
 {
     --pos;
-    auto newnode = new dllist_node<T>{T(std::forward<Args>(args)...)};
-    auto nextnode = dllist_node<T>::insert(pos.prevptr_, pos.nodeptr_, newnode);
+    auto newnode = new_node(std::in_place, std::forward<Args>(args)...);
+    auto nextnode = dllist_node<T, LinkTraits>::insert(pos.prevptr_, pos.nodeptr_, newnode);
     size_++;
+    if (pos.nodeptr_ == front_)
+        index_pushed_front(newnode);
+    else
+        index_changed_before(nextnode);
     return iterator{newnode, nextnode};
 }
 
@@ -543,177 +1033,422 @@ void emplace_back(Args&&... args)
 iterator insert(iterator pos, value_type const& value)
 {
     --pos;
-    auto newnode = new dllist_node<T>{value};
-    auto nextnode = dllist_node<T>::insert(pos.prevptr_, pos.nodeptr_, newnode);
+    auto newnode = new_node(value);
+    auto nextnode = dllist_node<T, LinkTraits>::insert(pos.prevptr_, pos.nodeptr_, newnode);
     size_++;
+    if (pos.nodeptr_ == front_)
+        index_pushed_front(newnode);
+    else
+        index_changed_before(nextnode);
     return iterator{newnode, nextnode};
 }
 
     template <typename InIter>
 void insert(iterator pos, InIter first, InIter const& last)
 {
-    for(;first != last; ++first) {
-        pos = insert(pos, *first);
-    }
+    link_new_nodes(pos.prevptr_, pos.nodeptr_, first, last);
 }
 
 iterator erase(iterator pos)
 {
     --pos;
-    auto oldnode{dllist_node<T>::remove(pos.prevptr_, pos.nodeptr_)};
+    auto oldnode{dllist_node<T, LinkTraits>::remove(pos.prevptr_, pos.nodeptr_)};
     size_--;
-    delete oldnode;
+    auto at_front = pos.nodeptr_ == front_;
+    if (at_front)
+        index_popped_front(oldnode);
     ++pos;
+    delete_node(oldnode);
+    if (!at_front)
+        index_changed_before(pos.nodeptr_);
     return pos;
 }
 
 iterator erase(iterator first, iterator const& last)
 {
-    int i = 0;
-    for(;first != last;i++) {
-        first = erase(first);
+    if (first == last)
+        return first;
+
+    auto p = first.prevptr_;
+    auto q = last.nodeptr_;
+
+    p->updateptr(first.nodeptr_, q);
+    q->updateptr(last.prevptr_, p);
+    size_ -= delete_chain(p, first.nodeptr_, q);
+    index_changed_before(q);
+
+    return iterator{p, q};
+}
+
+// The operations below only relink nodes: none allocates or copies an
+// element. Splicing and merging between lists requires equal allocators.
+
+void reverse() noexcept
+{
+    std::swap(front_, back_);
+    invalidate_index();
+}
+
+void splice(iterator pos, dllist& l)
+{
+    if (l.empty())
+        return;
+
+    auto a = l.front_->nextptr(l.back_);
+    auto b = l.back_->nextptr(l.front_);
+    transfer(pos.prevptr_, pos.nodeptr_, l.front_, a, b, l.back_);
+
+    size_ += l.size_;
+    l.size_ = 0;
+    invalidate_index();
+    l.invalidate_index();
+}
+
+void splice(iterator pos, dllist&& l)
+{
+    splice(pos, l);
+}
+
+void splice(iterator pos, dllist& l, iterator it)
+{
+    auto a = it.nodeptr_;
+    if (pos.nodeptr_ == a || pos.prevptr_ == a)
+        return;
+
+    transfer(pos.prevptr_, pos.nodeptr_, it.prevptr_, a, a, a->nextptr(it.prevptr_));
+
+    l.size_--;
+    size_++;
+    invalidate_index();
+    l.invalidate_index();
+}
+
+void splice(iterator pos, dllist&& l, iterator it)
+{
+    splice(pos, l, it);
+}
+
+void splice(iterator pos, dllist& l, iterator first, iterator last)
+{
+    if (first == last || pos == first || pos == last)
+        return;
+
+    if (&l != this)
+    {
+        auto n = static_cast<size_type>(std::distance(first, last));
+        l.size_ -= n;
+        size_ += n;
     }
-    return first;
+
+    transfer(pos.prevptr_, pos.nodeptr_,
+            first.prevptr_, first.nodeptr_, last.prevptr_, last.nodeptr_);
+    invalidate_index();
+    l.invalidate_index();
+}
+
+void splice(iterator pos, dllist&& l, iterator first, iterator last)
+{
+    splice(pos, l, first, last);
+}
+
+    template <typename Compare>
+void merge(dllist& l, Compare comp)
+{
+    if (&l == this || l.empty())
+        return;
+
+    auto key = front_;
+    auto a = detach_chain(key);
+    auto b = l.detach_chain(key);
+    attach_chain(merge_chains(a, b, key, comp), key);
+
+    size_ += l.size_;
+    l.size_ = 0;
+}
+
+void merge(dllist& l)
+{
+    merge(l, std::less<>{});
+}
+
+    template <typename Compare>
+void merge(dllist&& l, Compare comp)
+{
+    merge(l, comp);
+}
+
+void merge(dllist&& l)
+{
+    merge(l);
+}
+
+// Stable bottom-up merge sort over the detached chain.
+    template <typename Compare>
+void sort(Compare comp)
+{
+    if (size_ < 2)
+        return;
+
+    auto key = front_;
+    node_ptr bins[std::numeric_limits<size_type>::digits];
+    std::size_t used = 0;
+
+    for (auto input = detach_chain(key); input != key; )
+    {
+        DLLIST_STATS(traversal_steps);
+        auto carry = input;
+        input = input->nextptr(key);
+        carry->setptr(key, key);
+
+        std::size_t i = 0;
+        for (; i < used && bins[i] != key; ++i)
+        {
+            carry = merge_chains(bins[i], carry, key, comp);
+            bins[i] = key;
+        }
+        if (i == used)
+            ++used;
+        bins[i] = carry;
+    }
+
+    auto result = key;
+    for (std::size_t i = 0; i < used; ++i)
+        if (bins[i] != key)
+            result = result == key ? bins[i] : merge_chains(bins[i], result, key, comp);
+
+    attach_chain(result, key);
+}
+
+void sort()
+{
+    sort(std::less<>{});
+}
+
+    template <typename BinaryPredicate>
+size_type unique(BinaryPredicate pred)
+{
+    auto old_size = size_;
+    if (size_ < 2)
+        return 0;
+
+    auto prev = front_->nextptr(back_);
+    auto node = prev->nextptr(front_);
+    auto before = front_;
+    while (node != back_)
+    {
+        DLLIST_STATS(traversal_steps);
+        if (pred(prev->to_node().datum(), node->to_node().datum()))
+        {
+            node = unlink(prev, node);
+        }
+        else
+        {
+            before = prev;
+            prev = node;
+            node = node->nextptr(before);
+        }
+    }
+    return old_size - size_;
+}
+
+size_type unique()
+{
+    return unique(std::equal_to<>{});
+}
+
+    template <typename Predicate>
+size_type remove_if(Predicate pred)
+{
+    auto old_size = size_;
+    auto prev = front_;
+    auto node = front_->nextptr(back_);
+    while (node != back_)
+    {
+        DLLIST_STATS(traversal_steps);
+        if (pred(node->to_node().datum()))
+        {
+            node = unlink(prev, node);
+        }
+        else
+        {
+            auto next = node->nextptr(prev);
+            prev = node;
+            node = next;
+        }
+    }
+    return old_size - size_;
+}
+
+// value may refer to an element of this list: that node is destroyed only
+// once the walk is over.
+size_type remove(value_type const& value)
+{
+    auto old_size = size_;
+    node_ptr self = nullptr;
+    auto prev = front_;
+    auto node = front_->nextptr(back_);
+    while (node != back_)
+    {
+        DLLIST_STATS(traversal_steps);
+        auto& v = node->to_node().datum();
+        if (v == value)
+        {
+            auto doomed = node;
+            node = detach(prev, node);
+            if (&v == &value)
+                self = doomed;
+            else
+                delete_node(doomed);
+        }
+        else
+        {
+            auto next = node->nextptr(prev);
+            prev = node;
+            node = next;
+        }
+    }
+    if (self)
+        delete_node(self);
+    return old_size - size_;
 }
 };
 
 //===========================================================================
 
-    template <typename T>
-inline void swap(dllist<T>& a, dllist<T>& b)
+    template <typename T, typename A, template <typename> class L>
+inline void swap(dllist<T, A, L>& a, dllist<T, A, L>& b)
 {
     a.swap(b);
 }
 
-    template <typename T>
-inline bool operator ==(dllist<T> const& a, dllist<T> const& b)
+    template <typename T, typename A, template <typename> class L>
+inline bool operator ==(dllist<T, A, L> const& a, dllist<T, A, L> const& b)
 {
     using std::equal;
     return equal( a.begin(), a.end(), b.begin(), b.end());
 }
 
-    template <typename T>
-inline bool operator !=(dllist<T> const& a, dllist<T> const& b)
+    template <typename T, typename A, template <typename> class L>
+inline bool operator !=(dllist<T, A, L> const& a, dllist<T, A, L> const& b)
 {
     return !operator ==(a,b);
 }
 
-    template <typename T>
-inline bool operator <(dllist<T> const& a, dllist<T> const& b)
+    template <typename T, typename A, template <typename> class L>
+inline bool operator <(dllist<T, A, L> const& a, dllist<T, A, L> const& b)
 {
     using std::lexicographical_compare;
     return lexicographical_compare( a.begin(), a.end(), b.begin(), b.end() );
 }
 
-    template <typename T>
-inline bool operator <=(dllist<T> const& a, dllist<T> const& b)
+    template <typename T, typename A, template <typename> class L>
+inline bool operator <=(dllist<T, A, L> const& a, dllist<T, A, L> const& b)
 {
     return !(a > b);
 }
 
-    template <typename T>
-inline bool operator >=(dllist<T> const& a, dllist<T> const& b)
+    template <typename T, typename A, template <typename> class L>
+inline bool operator >=(dllist<T, A, L> const& a, dllist<T, A, L> const& b)
 {
     return !(a < b);
 }
 
-    template <typename T>
-inline bool operator >(dllist<T> const& a, dllist<T> const& b)
+    template <typename T, typename A, template <typename> class L>
+inline bool operator >(dllist<T, A, L> const& a, dllist<T, A, L> const& b)
 {
     return b < a;
 }
 
-    template <typename T>
-inline auto begin(dllist<T>& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto begin(dllist<T, A, L>& a)
 {
     return a.begin();
 }
 
-    template <typename T>
-inline auto begin(dllist<T> const& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto begin(dllist<T, A, L> const& a)
 {
     return a.begin();
 }
 
-    template <typename T>
-inline auto cbegin(dllist<T> const& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto cbegin(dllist<T, A, L> const& a)
 {
     return a.begin();
 }
 
-    template <typename T>
-inline auto rbegin(dllist<T>& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto rbegin(dllist<T, A, L>& a)
 {
     return a.rbegin();
 }
 
-    template <typename T>
-inline auto rbegin(dllist<T> const& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto rbegin(dllist<T, A, L> const& a)
 {
     return a.rbegin();
 }
 
-    template <typename T>
-inline auto crbegin(dllist<T> const& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto crbegin(dllist<T, A, L> const& a)
 {
     return a.crbegin();
 }
-    template <typename T>
-inline auto end(dllist<T>& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto end(dllist<T, A, L>& a)
 {
     return a.end();
 }
 
-    template <typename T>
-inline auto end(dllist<T> const& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto end(dllist<T, A, L> const& a)
 {
     return a.end();
 }
 
-    template <typename T>
-inline auto cend(dllist<T> const& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto cend(dllist<T, A, L> const& a)
 {
     return a.end();
 }
 
-    template <typename T>
-inline auto rend(dllist<T>& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto rend(dllist<T, A, L>& a)
 {
     return a.rend();
 }
 
-    template <typename T>
-inline auto rend(dllist<T> const& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto rend(dllist<T, A, L> const& a)
 {
     return a.rend();
 }
 
-    template <typename T>
-inline auto crend(dllist<T> const& a)
+    template <typename T, typename A, template <typename> class L>
+inline auto crend(dllist<T, A, L> const& a)
 {
     return a.crend();
 }
 
 //===========================================================================
 
-template <typename T>
-class dllist_iter :
-    public std::iterator<
-    std::bidirectional_iterator_tag,
-    T,
-    std::ptrdiff_t,
-    T*,
-    T&
-    >
+template <typename T, template <typename> class LinkTraits>
+class dllist_iter
 {
     private:
-        friend class dllist<T>;
-        friend class dllist_citer<T>;
+        template <typename, typename, template <typename> class> friend class dllist;
+        friend class dllist_citer<T, LinkTraits>;
 
-        dllist_node_ptr_only<T>* prevptr_;
-        dllist_node_ptr_only<T>* nodeptr_;
+        dllist_node_ptr_only<T, LinkTraits>* prevptr_;
+        dllist_node_ptr_only<T, LinkTraits>* nodeptr_;
 
     public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
         dllist_iter() :
             prevptr_{nullptr},
             nodeptr_{nullptr}
@@ -730,8 +1465,8 @@ class dllist_iter :
 
 
         dllist_iter(
-                dllist_node_ptr_only<T>* prev,
-                dllist_node_ptr_only<T>* xornode
+                dllist_node_ptr_only<T, LinkTraits>* prev,
+                dllist_node_ptr_only<T, LinkTraits>* xornode
                 ) :
             prevptr_{prev},
             nodeptr_{xornode}
@@ -762,6 +1497,7 @@ class dllist_iter :
 
         dllist_iter& operator ++()
         {
+            DLLIST_STATS(traversal_steps);
             auto next_nodeptr_ = nodeptr_->nextptr(prevptr_);
             prevptr_ = nodeptr_;
             nodeptr_ = next_nodeptr_;
@@ -770,13 +1506,14 @@ class dllist_iter :
 
         dllist_iter operator ++(int)
         {
-            dllist_iter<T> tmp(*this);
+            dllist_iter<T, LinkTraits> tmp(*this);
             operator ++();
             return tmp;
         }
 
         dllist_iter& operator --()
         {
+            DLLIST_STATS(traversal_steps);
             auto prev_prevptr_ = prevptr_->nextptr(nodeptr_);
             nodeptr_ = prevptr_;
             prevptr_ = prev_prevptr_;
@@ -785,7 +1522,7 @@ class dllist_iter :
 
         dllist_iter operator --(int)
         {
-            dllist_iter<T> tmp(*this);
+            dllist_iter<T, LinkTraits> tmp(*this);
             operator --();
             return tmp;
         }
@@ -793,23 +1530,22 @@ class dllist_iter :
 
 //===========================================================================
 
-template <typename T>
-class dllist_citer :
-    public std::iterator<
-    std::bidirectional_iterator_tag,
-    T const,
-    std::ptrdiff_t,
-    T const*,
-    T const&
-    >
+template <typename T, template <typename> class LinkTraits>
+class dllist_citer
 {
     private:
-        friend class dllist<T>;
+        template <typename, typename, template <typename> class> friend class dllist;
 
-        dllist_node_ptr_only<T> const* prevptr_; // Used to compute next node address
-        dllist_node_ptr_only<T> const* nodeptr_; // Cur node; for xorptr_ value
+        dllist_node_ptr_only<T, LinkTraits> const* prevptr_; // Used to compute next node address
+        dllist_node_ptr_only<T, LinkTraits> const* nodeptr_; // Cur node; for xorptr_ value
 
     public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T const*;
+        using reference = T const&;
+
         dllist_citer() :
             prevptr_{nullptr},
             nodeptr_{nullptr}
@@ -825,33 +1561,33 @@ class dllist_citer :
         ~dllist_citer() = default;
 
         dllist_citer(
-                dllist_node_ptr_only<T> const* prev,
-                dllist_node_ptr_only<T> const* xornode
+                dllist_node_ptr_only<T, LinkTraits> const* prev,
+                dllist_node_ptr_only<T, LinkTraits> const* xornode
                 ) :
             prevptr_{prev},
             nodeptr_{xornode}
         {
         }
 
-        dllist_citer(dllist_iter<T> const& i) :
-            nodeptr_{i.nodeptr_},
-            prevptr_{i.prevptr_}
+        dllist_citer(dllist_iter<T, LinkTraits> const& i) :
+            prevptr_{i.prevptr_},
+            nodeptr_{i.nodeptr_}
         {
         }
 
-        dllist_citer& operator =(dllist_iter<T> const& i)
+        dllist_citer& operator =(dllist_iter<T, LinkTraits> const& i)
         {
-            nodeptr_ = i.nodeptr_;
             prevptr_ = i.prevptr_;
+            nodeptr_ = i.nodeptr_;
             return *this;
         }
 
-        bool operator ==(dllist_iter<T> const& i) const
+        bool operator ==(dllist_iter<T, LinkTraits> const& i) const
         {
             return nodeptr_ == i.nodeptr_;
         }
 
-        bool operator !=(dllist_iter<T> const& i) const
+        bool operator !=(dllist_iter<T, LinkTraits> const& i) const
         {
             return !operator ==(i);
         }
@@ -879,6 +1615,7 @@ class dllist_citer :
 
         dllist_citer& operator ++()
         {
+            DLLIST_STATS(traversal_steps);
             auto next_nodeptr_ = nodeptr_->nextptr(prevptr_);
             prevptr_ = nodeptr_;
             nodeptr_ = next_nodeptr_;
@@ -887,13 +1624,14 @@ class dllist_citer :
 
         dllist_citer operator ++(int)
         {
-            dllist_citer<T> tmp(*this);
+            dllist_citer<T, LinkTraits> tmp(*this);
             operator ++();
             return tmp;
         }
 
         dllist_citer& operator --()
         {
+            DLLIST_STATS(traversal_steps);
             auto prev_prevptr_ = prevptr_->nextptr(nodeptr_);
             nodeptr_ = prevptr_;
             prevptr_ = prev_prevptr_;
@@ -902,19 +1640,19 @@ class dllist_citer :
 
         dllist_citer operator --(int)
         {
-            dllist_citer<T> tmp(*this);
+            dllist_citer<T, LinkTraits> tmp(*this);
             operator --();
             return tmp;
         }
 };
 
-    template <typename T>
-inline bool operator ==(dllist_iter<T> const& i, dllist_citer<T> const& j)
+    template <typename T, template <typename> class L>
+inline bool operator ==(dllist_iter<T, L> const& i, dllist_citer<T, L> const& j)
 {
     return j == i;
 }
-    template <typename T>
-inline bool operator !=(dllist_iter<T> const& i, dllist_citer<T> const& j)
+    template <typename T, template <typename> class L>
+inline bool operator !=(dllist_iter<T, L> const& i, dllist_citer<T, L> const& j)
 {
     return j != i;
 }
@@ -0,0 +1,255 @@
+#ifndef DLLIST_CONCURRENT_HXX
+#define DLLIST_CONCURRENT_HXX
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "dllist.hxx"
+#include "node_pool.hxx"
+
+template <
+    typename T,
+    typename Alloc = pool_allocator<T>,
+    template <typename> class LinkTraits = xorptr_traits
+    >
+class dllist_concurrent;    // two-ended concurrent XOR list (deque) type
+
+//===========================================================================
+
+// Concurrent deque / work-stealing queue on the XOR list.
+//
+// Each end has its own lock: the owner pushes and pops at the back, thieves
+// push or steal at the front, and the two only serialise against each other
+// when the list is nearly empty. A back operation touches back_, the last
+// node and its neighbour; a front operation touches front_, the first node
+// and its neighbour. These are disjoint while at least fast_path_min
+// elements remain, which each fast path checks and reserves with a CAS on
+// size_. Below that, an operation takes both locks.
+//
+// Nodes are only dereferenced under the lock of the end that owns them and
+// are freed only after being unlinked, so recycling them through the
+// (thread-safe) allocator needs no hazard pointers or epochs. Elements are
+// constructed, moved out and destroyed outside the locks.
+template <typename T, typename Alloc, template <typename> class LinkTraits>
+class dllist_concurrent
+{
+    static_assert(!xorptr_needs_window<LinkTraits>::value
+            || allocator_uses_window<Alloc>::value,
+            "this link policy needs an allocator drawing from one 4 GiB window");
+
+    private:
+        using node_type = dllist_node<T, LinkTraits>;
+        using node_ptr = dllist_node_ptr_only<T, LinkTraits>*;
+        using node_allocator_type =
+            typename std::allocator_traits<Alloc>::template rebind_alloc<node_type>;
+        using node_alloc_traits = std::allocator_traits<node_allocator_type>;
+        using sentinel_allocator_type =
+            typename std::allocator_traits<Alloc>::template rebind_alloc<
+                dllist_node_ptr_only<T, LinkTraits>
+                >;
+        using sentinel_alloc_traits = std::allocator_traits<sentinel_allocator_type>;
+
+        static constexpr std::size_t fast_path_min = 4;
+        static constexpr std::size_t cache_line = 64;
+
+        node_ptr front_;
+        node_ptr back_;
+        node_allocator_type alloc_;
+
+        alignas(cache_line) std::mutex front_mutex_;
+        alignas(cache_line) std::mutex back_mutex_;
+        alignas(cache_line) std::atomic<std::size_t> size_;
+
+        template <typename... Args>
+        node_type* new_node(Args&&... args)
+        {
+            auto p = node_alloc_traits::allocate(alloc_, 1);
+            try {
+                node_alloc_traits::construct(alloc_, p, std::in_place, std::forward<Args>(args)...);
+            } catch(...) {
+                node_alloc_traits::deallocate(alloc_, p, 1);
+                throw;
+            }
+            DLLIST_STATS(node_allocs);
+            return p;
+        }
+
+        void delete_node(node_ptr p)
+        {
+            DLLIST_STATS(node_frees);
+            auto n = &p->to_node();
+            node_alloc_traits::destroy(alloc_, n);
+            node_alloc_traits::deallocate(alloc_, n, 1);
+        }
+
+        // Reserves one element for removal if the fast path is safe.
+        bool try_reserve()
+        {
+            auto n = size_.load(std::memory_order_acquire);
+            while (n >= fast_path_min)
+                if (size_.compare_exchange_weak(n, n - 1, std::memory_order_acq_rel))
+                    return true;
+            return false;
+        }
+
+        // far and near are the opposite and the own end's sentinels, in the
+        // order dllist_node_ptr_only::insert/remove take them.
+        void push(std::mutex& m, node_ptr far, node_ptr near, node_type* node)
+        {
+            {
+                std::lock_guard<std::mutex> lock{m};
+                if (size_.load(std::memory_order_acquire) >= fast_path_min)
+                {
+                    dllist_node_ptr_only<T, LinkTraits>::insert(far, near, node);
+                    size_.fetch_add(1, std::memory_order_acq_rel);
+                    return;
+                }
+            }
+
+            std::scoped_lock lock{front_mutex_, back_mutex_};
+            dllist_node_ptr_only<T, LinkTraits>::insert(far, near, node);
+            size_.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        bool pop(std::mutex& m, node_ptr far, node_ptr near, T& out)
+        {
+            node_ptr node = nullptr;
+            {
+                std::lock_guard<std::mutex> lock{m};
+                if (try_reserve())
+                    node = dllist_node_ptr_only<T, LinkTraits>::remove(far, near);
+            }
+
+            if (!node)
+            {
+                std::scoped_lock lock{front_mutex_, back_mutex_};
+                if (size_.load(std::memory_order_acquire) == 0)
+                    return false;
+                size_.fetch_sub(1, std::memory_order_acq_rel);
+                node = dllist_node_ptr_only<T, LinkTraits>::remove(far, near);
+            }
+
+            try {
+                out = std::move(node->to_node().datum());
+            } catch(...) {
+                delete_node(node);
+                throw;
+            }
+            delete_node(node);
+            return true;
+        }
+
+    public:
+        using value_type = T;
+        using allocator_type = Alloc;
+        using size_type = std::size_t;
+
+        dllist_concurrent() :
+            dllist_concurrent{Alloc{}}
+        {}
+
+        explicit dllist_concurrent(Alloc const& alloc) :
+            alloc_{alloc},
+            size_{0}
+        {
+            sentinel_allocator_type a{alloc_};
+            front_ = sentinel_alloc_traits::allocate(a, 1);
+            try {
+                back_ = sentinel_alloc_traits::allocate(a, 1);
+            } catch(...) {
+                sentinel_alloc_traits::deallocate(a, front_, 1);
+                throw;
+            }
+            sentinel_alloc_traits::construct(a, front_, back_, back_);
+            sentinel_alloc_traits::construct(a, back_, front_, front_);
+        }
+
+        dllist_concurrent(dllist_concurrent const&) = delete;
+        dllist_concurrent& operator =(dllist_concurrent const&) = delete;
+
+        ~dllist_concurrent()
+        {
+            auto prev = front_;
+            auto node = front_->nextptr(back_);
+            while (node != back_)
+            {
+                DLLIST_STATS(traversal_steps);
+                auto next = node->nextptr(prev);
+                prev = node;
+                delete_node(node);
+                node = next;
+            }
+
+            sentinel_allocator_type a{alloc_};
+            for (auto p : { front_, back_ })
+            {
+                sentinel_alloc_traits::destroy(a, p);
+                sentinel_alloc_traits::deallocate(a, p, 1);
+            }
+        }
+
+        // Only a snapshot while other threads are running.
+        size_type size() const
+        {
+            return size_.load(std::memory_order_acquire);
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        template <typename... Args>
+        void emplace_back(Args&&... args)
+        {
+            push(back_mutex_, front_, back_, new_node(std::forward<Args>(args)...));
+        }
+
+        void push_back(value_type const& v)
+        {
+            emplace_back(v);
+        }
+
+        void push_back(value_type&& v)
+        {
+            emplace_back(std::move(v));
+        }
+
+        template <typename... Args>
+        void emplace_front(Args&&... args)
+        {
+            push(front_mutex_, back_, front_, new_node(std::forward<Args>(args)...));
+        }
+
+        void push_front(value_type const& v)
+        {
+            emplace_front(v);
+        }
+
+        void push_front(value_type&& v)
+        {
+            emplace_front(std::move(v));
+        }
+
+        // Owner end. Returns false if the list was empty.
+        bool try_pop_back(value_type& out)
+        {
+            return pop(back_mutex_, front_, back_, out);
+        }
+
+        // Thief end. Returns false if the list was empty.
+        bool try_pop_front(value_type& out)
+        {
+            return pop(front_mutex_, back_, front_, out);
+        }
+
+        bool try_steal(value_type& out)
+        {
+            return try_pop_front(out);
+        }
+};
+
+#endif // ifndef DLLIST_CONCURRENT_HXX
@@ -0,0 +1,534 @@
+#ifndef DLLIST_MAPPED_HXX
+#define DLLIST_MAPPED_HXX
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dllist.hxx"
+#include "window_arena.hxx"
+
+// On-disk dllist format for trivially copyable T.
+//
+// A file holds a header, the two sentinels and then the nodes, all as the
+// in-memory dllist_node_ptr_only / dllist_node objects of
+// xorptr_offset32_traits. Links are XORs of file offsets. Mapping the file
+// at the start of a 4 GiB-aligned window makes every node's address equal
+// window base + offset, so those offset links are exactly what
+// xorptr_offset32_traits expects and the file can be iterated in place with
+// the ordinary dllist iterators. Files are limited to 4 GiB and use the
+// writing machine's byte order and layout of T. POSIX only.
+
+//===========================================================================
+
+struct dllist_file_header
+{
+    static constexpr char expected_magic[8] = { 'X', 'O', 'R', 'D', 'L', 'L', 0, 1 };
+
+    char magic[8];
+    std::uint32_t value_size;
+    std::uint32_t node_size;
+    std::uint32_t front;        // offset of the front sentinel
+    std::uint32_t back;         // offset of the back sentinel
+    std::uint64_t count;        // number of elements
+    std::uint64_t end;          // bytes in use
+};
+
+namespace dllist_detail {
+
+// Offsets travel through the link traits as pointers relative to address 0.
+    template <typename P>
+inline P offset_ptr(std::uint32_t off) noexcept
+{
+    return reinterpret_cast<P>(static_cast<std::uintptr_t>(off));
+}
+
+    template <typename P>
+inline std::uint32_t ptr_offset(P p) noexcept
+{
+    return static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(p));
+}
+
+[[noreturn]] inline void throw_errno(char const* what)
+{
+    throw std::system_error{errno, std::generic_category(), what};
+}
+
+inline void pwrite_all(int fd, void const* data, std::size_t size, std::uint64_t off)
+{
+    auto p = static_cast<unsigned char const*>(data);
+    while (size)
+    {
+        auto n = ::pwrite(fd, p, size, static_cast<off_t>(off));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw_errno("dllist file write");
+        }
+        p += n;
+        off += static_cast<std::uint64_t>(n);
+        size -= static_cast<std::size_t>(n);
+    }
+}
+
+inline void pread_all(int fd, void* data, std::size_t size, std::uint64_t off)
+{
+    auto p = static_cast<unsigned char*>(data);
+    while (size)
+    {
+        auto n = ::pread(fd, p, size, static_cast<off_t>(off));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw std::runtime_error{"dllist file: truncated"};
+        p += n;
+        off += static_cast<std::uint64_t>(n);
+        size -= static_cast<std::size_t>(n);
+    }
+}
+
+// Offsets of the sentinels and of the first node, which follow the header.
+    template <typename T>
+struct file_layout
+{
+    using node_base = dllist_node_ptr_only<T, xorptr_offset32_traits>;
+    using node_type = dllist_node<T, xorptr_offset32_traits>;
+
+    static constexpr std::uint32_t round_up(std::size_t n) noexcept
+    {
+        return static_cast<std::uint32_t>(
+                (n + alignof(node_type) - 1) / alignof(node_type) * alignof(node_type));
+    }
+
+    static constexpr std::uint32_t front = round_up(sizeof(dllist_file_header));
+    static constexpr std::uint32_t back = round_up(front + sizeof(node_base));
+    static constexpr std::uint32_t first_node = round_up(back + sizeof(node_base));
+};
+
+// Checks that the header describes T and that the sentinels and count
+// nodes lie inside the file. The links themselves are trusted.
+    template <typename T>
+void check_header(dllist_file_header const& h, std::uint64_t file_size)
+{
+    using layout = file_layout<T>;
+    if (std::memcmp(h.magic, dllist_file_header::expected_magic, sizeof h.magic) != 0
+            || h.value_size != sizeof(T)
+            || h.node_size != sizeof(typename layout::node_type)
+            || h.front != layout::front
+            || h.back != layout::back
+            || h.end > file_size
+            || h.end < layout::first_node
+            || h.count > (h.end - layout::first_node) / h.node_size)
+        throw std::runtime_error{"dllist file: bad header or element type"};
+}
+
+} // namespace dllist_detail
+
+//===========================================================================
+
+// Creates a dllist file, or opens one to append to. Appended nodes are
+// buffered and written by flush(), which then relinks the previous tail
+// node and rewrites the sentinels and the header; the destructor flushes.
+// Readers see appended elements after the next flush(), and must not
+// traverse the file while a flush is under way.
+template <typename T>
+class dllist_file_writer
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+            "dllist files hold trivially copyable elements only");
+
+    private:
+        using node_base = dllist_node_ptr_only<T, xorptr_offset32_traits>;
+        using node_type = dllist_node<T, xorptr_offset32_traits>;
+        using xorptr_type = typename node_base::xorptr_type;
+        using layout = dllist_detail::file_layout<T>;
+
+        static constexpr std::size_t flush_bytes = std::size_t{1} << 20;
+        static constexpr std::uint64_t max_file_size = std::uint64_t{1} << 32;
+
+        int fd_;
+        dllist_file_header header_;
+        std::uint32_t flushed_end_;     // header_.end as of the last flush
+        std::uint32_t tail_;            // offset of the last node, if any
+        std::vector<unsigned char> pending_;
+
+        // Copy of the last node already on disk, relinked at the next flush.
+        alignas(node_type) unsigned char flushed_tail_[sizeof(node_type)];
+
+        static node_base* at(std::uint32_t off) noexcept
+        {
+            return dllist_detail::offset_ptr<node_base*>(off);
+        }
+
+        static node_base* record(unsigned char* p) noexcept
+        {
+            return std::launder(reinterpret_cast<node_type*>(p));
+        }
+
+        node_base* pending_record(std::uint32_t off) noexcept
+        {
+            return record(pending_.data() + (off - flushed_end_));
+        }
+
+        void write_sentinels()
+        {
+            auto first = header_.count ? layout::first_node : header_.back;
+            auto last = header_.count ? tail_ : header_.front;
+            node_base front{at(header_.back), at(first)};
+            node_base back{at(header_.front), at(last)};
+            dllist_detail::pwrite_all(fd_, &front, sizeof front, header_.front);
+            dllist_detail::pwrite_all(fd_, &back, sizeof back, header_.back);
+        }
+
+    public:
+        using value_type = T;
+
+        explicit dllist_file_writer(char const* path, bool append = false) :
+            fd_{::open(path, O_RDWR | O_CREAT | (append ? 0 : O_TRUNC), 0644)},
+            header_{},
+            tail_{}
+        {
+            if (fd_ < 0)
+                dllist_detail::throw_errno("dllist file open");
+
+            try {
+                struct ::stat st;
+                if (::fstat(fd_, &st) != 0)
+                    dllist_detail::throw_errno("dllist file stat");
+
+                if (append && st.st_size != 0)
+                {
+                    dllist_detail::pread_all(fd_, &header_, sizeof header_, 0);
+                    dllist_detail::check_header<T>(header_, static_cast<std::uint64_t>(st.st_size));
+                    if (header_.count)
+                    {
+                        alignas(node_base) unsigned char back[sizeof(node_base)];
+                        dllist_detail::pread_all(fd_, back, sizeof back, header_.back);
+                        auto last = std::launder(reinterpret_cast<node_base*>(back))
+                            ->nextptr(at(header_.front));
+                        tail_ = dllist_detail::ptr_offset(last);
+                        dllist_detail::pread_all(fd_, flushed_tail_, sizeof flushed_tail_, tail_);
+                    }
+                }
+                else
+                {
+                    std::memcpy(header_.magic, dllist_file_header::expected_magic, sizeof header_.magic);
+                    header_.value_size = sizeof(T);
+                    header_.node_size = sizeof(node_type);
+                    header_.front = layout::front;
+                    header_.back = layout::back;
+                    header_.end = layout::first_node;
+                    write_sentinels();
+                    dllist_detail::pwrite_all(fd_, &header_, sizeof header_, 0);
+                    if (::ftruncate(fd_, static_cast<off_t>(header_.end)) != 0)
+                        dllist_detail::throw_errno("dllist file truncate");
+                }
+                flushed_end_ = static_cast<std::uint32_t>(header_.end);
+            } catch(...) {
+                ::close(fd_);
+                throw;
+            }
+        }
+
+        dllist_file_writer(dllist_file_writer const&) = delete;
+        dllist_file_writer& operator =(dllist_file_writer const&) = delete;
+
+        ~dllist_file_writer()
+        {
+            try {
+                flush();
+            } catch(...) {}
+            ::close(fd_);
+        }
+
+        std::uint64_t size() const noexcept
+        {
+            return header_.count;
+        }
+
+        void push_back(T const& v)
+        {
+            if (header_.end + sizeof(node_type) > max_file_size)
+                throw std::length_error{"dllist file: exceeds 4 GiB"};
+
+            auto off = static_cast<std::uint32_t>(header_.end);
+            auto prev = header_.count ? tail_ : header_.front;
+
+            pending_.resize(pending_.size() + sizeof(node_type));
+            ::new (pending_.data() + (off - flushed_end_))
+                node_type{v, xorptr_type{at(prev), at(header_.back)}};
+            if (header_.count && tail_ >= flushed_end_)
+                pending_record(tail_)->updateptr(at(header_.back), at(off));
+
+            tail_ = off;
+            header_.end += sizeof(node_type);
+            ++header_.count;
+
+            if (pending_.size() >= flush_bytes)
+                flush();
+        }
+
+        template <typename InIter>
+        void append(InIter first, InIter const& last)
+        {
+            for (; first != last; ++first)
+                push_back(*first);
+        }
+
+        void flush()
+        {
+            if (pending_.empty())
+                return;
+
+            dllist_detail::pwrite_all(fd_, pending_.data(), pending_.size(), flushed_end_);
+
+            // The old tail only learns about its successor once that exists.
+            if (header_.count * sizeof(node_type) > pending_.size())
+            {
+                auto old_tail = record(flushed_tail_);
+                old_tail->updateptr(at(header_.back), at(flushed_end_));
+                auto old_off = flushed_end_ - static_cast<std::uint32_t>(sizeof(node_type));
+                dllist_detail::pwrite_all(fd_, flushed_tail_, sizeof flushed_tail_, old_off);
+            }
+
+            write_sentinels();
+            dllist_detail::pwrite_all(fd_, &header_, sizeof header_, 0);
+
+            std::memcpy(flushed_tail_, pending_.data() + pending_.size() - sizeof(node_type),
+                    sizeof flushed_tail_);
+            pending_.clear();
+            flushed_end_ = static_cast<std::uint32_t>(header_.end);
+        }
+};
+
+//===========================================================================
+
+// View of a dllist file, iterated in place through the mapping without
+// deserialising or allocating nodes. The file is mapped read-only and only
+// const iterators are offered, unless CopyOnWrite is set: the mapping is
+// then private and writable, and elements may be modified through iterator.
+// Such changes stay private to the view and are lost on refresh().
+//
+// size(), begin() and end() remap the file if a writer has flushed since
+// it was mapped, as the old tail's link and the sentinels then already
+// point past the mapping. A copy-on-write view loses its changes then, as
+// on refresh().
+template <typename T, bool CopyOnWrite = false>
+class dllist_mapped_view
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+            "dllist files hold trivially copyable elements only");
+
+    private:
+        using node_base = dllist_node_ptr_only<T, xorptr_offset32_traits>;
+
+        window_reservation window_;
+        int fd_;
+        mutable std::size_t mapped_;
+        mutable std::uint64_t end_;     // header().end as of the last map()
+        void* live_header_;             // shared mapping of the header alone
+
+        dllist_file_header const& header() const noexcept
+        {
+            return *reinterpret_cast<dllist_file_header const*>(window_.base());
+        }
+
+        node_base* at(std::uint32_t off) const noexcept
+        {
+            return reinterpret_cast<node_base*>(window_.base() + off);
+        }
+
+        void map() const
+        {
+            struct ::stat st;
+            if (::fstat(fd_, &st) != 0)
+                dllist_detail::throw_errno("dllist file stat");
+            auto size = static_cast<std::uint64_t>(st.st_size);
+            if (size < sizeof(dllist_file_header) || size > window_reservation::window_size)
+                throw std::runtime_error{"dllist file: bad size"};
+
+            // Drop the previous mapping first in case the file shrank.
+            if (mapped_ && ::mmap(window_.base(), mapped_, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0) == MAP_FAILED)
+                dllist_detail::throw_errno("dllist file mmap");
+            mapped_ = 0;
+
+            auto p = ::mmap(window_.base(), static_cast<std::size_t>(size),
+                    CopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ,
+                    (CopyOnWrite ? MAP_PRIVATE : MAP_SHARED) | MAP_FIXED,
+                    fd_, 0);
+            if (p == MAP_FAILED)
+                dllist_detail::throw_errno("dllist file mmap");
+            mapped_ = static_cast<std::size_t>(size);
+
+            dllist_detail::check_header<T>(header(), size);
+            end_ = header().end;
+        }
+
+        // Kept apart from the window, whose header page stops following
+        // the file once a copy-on-write view modifies it.
+        void map_live_header()
+        {
+            live_header_ = ::mmap(nullptr, sizeof(dllist_file_header), PROT_READ,
+                    MAP_SHARED, fd_, 0);
+            if (live_header_ == MAP_FAILED)
+                dllist_detail::throw_errno("dllist file mmap");
+        }
+
+        void sync() const
+        {
+            if (static_cast<dllist_file_header const*>(live_header_)->end != end_)
+                map();
+        }
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using const_iterator = dllist_citer<T, xorptr_offset32_traits>;
+        using iterator = std::conditional_t<CopyOnWrite,
+              dllist_iter<T, xorptr_offset32_traits>, const_iterator>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        explicit dllist_mapped_view(char const* path) :
+            fd_{::open(path, O_RDONLY)},
+            mapped_{},
+            end_{},
+            live_header_{MAP_FAILED}
+        {
+            if (fd_ < 0)
+                dllist_detail::throw_errno("dllist file open");
+            try {
+                map();
+                map_live_header();
+            } catch(...) {
+                ::close(fd_);
+                throw;
+            }
+        }
+
+        dllist_mapped_view(dllist_mapped_view const&) = delete;
+        dllist_mapped_view& operator =(dllist_mapped_view const&) = delete;
+
+        ~dllist_mapped_view()
+        {
+            ::munmap(live_header_, sizeof(dllist_file_header));
+            ::close(fd_);
+        }
+
+        // Remaps the file unconditionally.
+        void refresh()
+        {
+            map();
+        }
+
+        size_type size() const
+        {
+            sync();
+            return static_cast<size_type>(header().count);
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        T const& front() const
+        {
+            return *begin();
+        }
+
+        T const& back() const
+        {
+            return *std::prev(end());
+        }
+
+        iterator begin()
+        {
+            sync();
+            auto f = at(header().front);
+            return iterator{f, f->nextptr(at(header().back))};
+        }
+
+        iterator end()
+        {
+            sync();
+            auto b = at(header().back);
+            return iterator{b->nextptr(at(header().front)), b};
+        }
+
+        const_iterator begin() const
+        {
+            sync();
+            node_base const* f = at(header().front);
+            return const_iterator{f, f->nextptr(at(header().back))};
+        }
+
+        const_iterator end() const
+        {
+            sync();
+            node_base const* b = at(header().back);
+            return const_iterator{b->nextptr(at(header().front)), b};
+        }
+
+        const_iterator cbegin() const
+        {
+            return begin();
+        }
+
+        const_iterator cend() const
+        {
+            return end();
+        }
+
+        reverse_iterator rbegin()
+        {
+            return reverse_iterator{end()};
+        }
+
+        reverse_iterator rend()
+        {
+            return reverse_iterator{begin()};
+        }
+
+        const_reverse_iterator rbegin() const
+        {
+            return const_reverse_iterator{end()};
+        }
+
+        const_reverse_iterator rend() const
+        {
+            return const_reverse_iterator{begin()};
+        }
+};
+
+//===========================================================================
+
+    template <typename T, typename A, template <typename> class L>
+void dllist_save(dllist<T, A, L> const& l, char const* path)
+{
+    dllist_file_writer<T> w{path};
+    w.append(l.begin(), l.end());
+}
+
+    template <typename T, typename A = std::allocator<T>>
+dllist<T, A> dllist_load(char const* path, A const& alloc = A{})
+{
+    dllist_mapped_view<T> v{path};
+    return dllist<T, A>(v.begin(), v.end(), alloc);
+}
+
+#endif // ifndef DLLIST_MAPPED_HXX
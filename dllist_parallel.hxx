@@ -0,0 +1,170 @@
+#ifndef DLLIST_PARALLEL_HXX
+#define DLLIST_PARALLEL_HXX
+
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dllist.hxx"
+
+// Parallel traversal of a dllist. The list is cut into one contiguous,
+// non-empty segment per thread. With the list's index enabled, segment
+// boundaries are moved to a nearby checkpoint where there is one, and are
+// found with iterator_at(); otherwise they are collected by one walk
+// inwards from both ends. Elements must not be
+// inserted or erased while a traversal runs.
+
+//===========================================================================
+
+namespace dllist_detail {
+
+inline unsigned parallel_thread_count(unsigned threads, std::size_t n)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    if (threads > n)
+        threads = n ? static_cast<unsigned>(n) : 1;
+    return threads;
+}
+
+// Calls work(k, first, last) for each of `threads` segments of l, running
+// segment k on its own thread (the last one on the calling thread).
+    template <typename List, typename Work>
+void for_each_segment(List& l, unsigned threads, Work& work)
+{
+    auto n = l.size();
+    threads = parallel_thread_count(threads, n);
+
+    // Element index at which each segment starts; strictly increasing. A
+    // boundary only moves to a checkpoint if that shifts it by at most an
+    // eighth of a segment, so segments stay balanced and non-empty.
+    auto stride = l.index_stride();
+    auto max_shift = n / threads / 8;
+    std::vector<std::size_t> starts(threads);
+    for (unsigned k = 1; k < threads; ++k)
+    {
+        auto i = n * k / threads;
+        if (stride != 0)
+        {
+            auto r = (i + stride / 2) / stride * stride;
+            auto shift = r > i ? r - i : i - r;
+            if (shift <= max_shift && r > starts[k - 1] && r < n)
+                i = r;
+        }
+        starts[k] = i;
+    }
+
+    std::vector<decltype(l.begin())> bounds(threads + 1, l.end());
+    if (stride != 0)
+    {
+        for (unsigned k = 0; k < threads; ++k)
+            bounds[k] = l.iterator_at(starts[k]);
+    }
+    else
+    {
+        auto it = l.begin();
+        std::size_t pos = 0;
+        unsigned k = 0;
+        for (; k < threads && starts[k] <= n / 2; ++k)
+        {
+            std::advance(it, static_cast<std::ptrdiff_t>(starts[k] - pos));
+            pos = starts[k];
+            bounds[k] = it;
+        }
+
+        it = l.end();
+        pos = n;
+        for (auto j = threads; j-- > k; )
+        {
+            std::advance(it, -static_cast<std::ptrdiff_t>(pos - starts[j]));
+            pos = starts[j];
+            bounds[j] = it;
+        }
+    }
+
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+
+    auto run = [&](unsigned k) {
+        try {
+            work(k, bounds[k], bounds[k + 1]);
+        } catch(...) {
+            errors[k] = std::current_exception();
+        }
+    };
+
+    try {
+        for (unsigned k = 0; k + 1 < threads; ++k)
+            workers.emplace_back(run, k);
+    } catch(...) {
+        for (auto& w : workers)
+            w.join();
+        throw;
+    }
+    run(threads - 1);
+
+    for (auto& w : workers)
+        w.join();
+    for (auto& e : errors)
+        if (e)
+            std::rethrow_exception(e);
+}
+
+} // namespace dllist_detail
+
+//===========================================================================
+
+// Applies f to every element of l using up to `threads` threads
+// (0 = std::thread::hardware_concurrency()).
+    template <typename T, typename A, template <typename> class L, typename F>
+void parallel_for_each(dllist<T, A, L>& l, F f, unsigned threads = 0)
+{
+    auto work = [&](unsigned, auto first, auto last) {
+        for (; first != last; ++first)
+            f(*first);
+    };
+    dllist_detail::for_each_segment(l, threads, work);
+}
+
+// reduce(init, transform(x)) over all elements, like std::transform_reduce.
+// Each thread reduces its own segment starting from the segment's first
+// transformed element, and the partial results are then folded into init in
+// segment order, so reduce must be associative.
+    template <
+    typename T, typename A, template <typename> class L,
+    typename R, typename Reduce, typename Transform
+    >
+R parallel_transform_reduce(
+        dllist<T, A, L> const& l, R init,
+        Reduce reduce, Transform transform,
+        unsigned threads = 0
+        )
+{
+    std::vector<std::optional<R>> partial(
+            dllist_detail::parallel_thread_count(threads, l.size()));
+
+    auto work = [&](unsigned k, auto first, auto last) {
+        if (first == last)
+            return;
+        R acc = transform(*first);
+        for (++first; first != last; ++first)
+            acc = reduce(std::move(acc), transform(*first));
+        partial[k] = std::move(acc);
+    };
+    dllist_detail::for_each_segment(l, threads, work);
+
+    auto result = std::move(init);
+    for (auto& p : partial)
+        if (p)
+            result = reduce(std::move(result), std::move(*p));
+    return result;
+}
+
+#endif // ifndef DLLIST_PARALLEL_HXX
@@ -0,0 +1,84 @@
+#ifndef DLLIST_STATS_HXX
+#define DLLIST_STATS_HXX
+
+#include <cstdint>
+
+// Opt-in hot-path counters for the XOR list family.
+//
+// Build with DLLIST_ENABLE_STATS defined to count, process-wide:
+//   node_allocs / node_frees  element nodes allocated and freed
+//   link_rewrites             updateptr / setptr and other link stores
+//   traversal_steps           iterator ++ / -- and nodes visited by the
+//                             list's own walks (clear, sort, merge, ...)
+// The counters are relaxed atomics, so they are safe to bump from the
+// concurrent and parallel code. Without the macro, DLLIST_STATS() expands to
+// nothing and dllist_stats_snapshot() returns zeros.
+
+struct dllist_stats
+{
+    std::uint64_t node_allocs;
+    std::uint64_t node_frees;
+    std::uint64_t link_rewrites;
+    std::uint64_t traversal_steps;
+};
+
+#ifdef DLLIST_ENABLE_STATS
+
+#include <atomic>
+
+namespace dllist_detail {
+
+struct stats_counters
+{
+    std::atomic<std::uint64_t> node_allocs{0};
+    std::atomic<std::uint64_t> node_frees{0};
+    std::atomic<std::uint64_t> link_rewrites{0};
+    std::atomic<std::uint64_t> traversal_steps{0};
+};
+
+inline stats_counters& stats() noexcept
+{
+    static stats_counters s;
+    return s;
+}
+
+} // namespace dllist_detail
+
+#define DLLIST_STATS(counter) \
+    (::dllist_detail::stats().counter.fetch_add(1, std::memory_order_relaxed))
+
+inline dllist_stats dllist_stats_snapshot() noexcept
+{
+    auto& s = dllist_detail::stats();
+    return dllist_stats{
+        s.node_allocs.load(std::memory_order_relaxed),
+        s.node_frees.load(std::memory_order_relaxed),
+        s.link_rewrites.load(std::memory_order_relaxed),
+        s.traversal_steps.load(std::memory_order_relaxed)
+    };
+}
+
+inline void dllist_stats_reset() noexcept
+{
+    auto& s = dllist_detail::stats();
+    s.node_allocs.store(0, std::memory_order_relaxed);
+    s.node_frees.store(0, std::memory_order_relaxed);
+    s.link_rewrites.store(0, std::memory_order_relaxed);
+    s.traversal_steps.store(0, std::memory_order_relaxed);
+}
+
+#else
+
+#define DLLIST_STATS(counter)
+
+inline dllist_stats dllist_stats_snapshot() noexcept
+{
+    return dllist_stats{};
+}
+
+inline void dllist_stats_reset() noexcept
+{}
+
+#endif // ifdef DLLIST_ENABLE_STATS
+
+#endif // ifndef DLLIST_STATS_HXX
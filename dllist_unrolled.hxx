@@ -0,0 +1,650 @@
+#ifndef DLLIST_UNROLLED_HXX
+#define DLLIST_UNROLLED_HXX
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+
+#include "dllist.hxx"
+
+template <typename T, std::size_t N>
+class dllist_unrolled_block;    // fixed-capacity element block
+
+template <typename Value, typename BlockIter>
+class dllist_unrolled_iter;     // unrolled list (const_)iterator type
+
+template <
+    typename T,
+    std::size_t N,
+    typename Alloc = std::allocator<T>,
+    template <typename> class LinkTraits = xorptr_traits
+    >
+class dllist_unrolled;          // unrolled doubly-linked list container type
+
+//===========================================================================
+
+// Up to N elements stored contiguously; the payload of one unrolled list node.
+template <typename T, std::size_t N>
+class dllist_unrolled_block final
+{
+    static_assert(N > 0, "dllist_unrolled_block needs a capacity of at least 1");
+
+    private:
+        std::size_t size_;
+        alignas(T) unsigned char storage_[N * sizeof(T)];
+
+    public:
+        dllist_unrolled_block() noexcept :
+            size_{}
+        {}
+
+        dllist_unrolled_block(dllist_unrolled_block const& b) :
+            size_{}
+        {
+            for (; size_ < b.size_; ++size_)
+                ::new (static_cast<void*>(data() + size_)) T(b.data()[size_]);
+        }
+
+        dllist_unrolled_block(dllist_unrolled_block&& b) :
+            size_{}
+        {
+            for (; size_ < b.size_; ++size_)
+                ::new (static_cast<void*>(data() + size_)) T(std::move(b.data()[size_]));
+        }
+
+        dllist_unrolled_block& operator =(dllist_unrolled_block const&) = delete;
+        dllist_unrolled_block& operator =(dllist_unrolled_block&&) = delete;
+
+        ~dllist_unrolled_block()
+        {
+            std::destroy(data(), data() + size_);
+        }
+
+        T* data() noexcept
+        {
+            return std::launder(reinterpret_cast<T*>(storage_));
+        }
+
+        T const* data() const noexcept
+        {
+            return std::launder(reinterpret_cast<T const*>(storage_));
+        }
+
+        std::size_t size() const noexcept
+        {
+            return size_;
+        }
+
+        bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        bool full() const noexcept
+        {
+            return size_ == N;
+        }
+
+        T& operator [](std::size_t i) noexcept
+        {
+            return data()[i];
+        }
+
+        T const& operator [](std::size_t i) const noexcept
+        {
+            return data()[i];
+        }
+
+        template <typename... Args>
+        void emplace(std::size_t i, Args&&... args)
+        {
+            auto d = data();
+            if (i == size_)
+            {
+                ::new (static_cast<void*>(d + size_)) T(std::forward<Args>(args)...);
+            }
+            else
+            {
+                T tmp(std::forward<Args>(args)...);
+                ::new (static_cast<void*>(d + size_)) T(std::move(d[size_ - 1]));
+                std::move_backward(d + i, d + size_ - 1, d + size_);
+                d[i] = std::move(tmp);
+            }
+            ++size_;
+        }
+
+        void erase(std::size_t i)
+        {
+            auto d = data();
+            std::move(d + i + 1, d + size_, d + i);
+            std::destroy_at(d + --size_);
+        }
+
+        // Moves elements [from, size()) to the end of b.
+        void move_tail_to(std::size_t from, dllist_unrolled_block& b)
+        {
+            auto d = data();
+            for (auto i = from; i < size_; ++i)
+            {
+                ::new (static_cast<void*>(b.data() + b.size_)) T(std::move(d[i]));
+                ++b.size_;
+            }
+            std::destroy(d + from, d + size_);
+            size_ = from;
+        }
+};
+
+//===========================================================================
+
+template <typename Value, typename BlockIter>
+class dllist_unrolled_iter
+{
+    private:
+        template <typename, std::size_t, typename, template <typename> class>
+            friend class dllist_unrolled;
+        template <typename, typename> friend class dllist_unrolled_iter;
+
+        BlockIter block_;
+        std::size_t index_;
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::remove_const_t<Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        dllist_unrolled_iter() :
+            block_{},
+            index_{}
+        {
+        }
+
+        dllist_unrolled_iter(BlockIter const& block, std::size_t index) :
+            block_{block},
+            index_{index}
+        {
+        }
+
+        operator dllist_unrolled_iter<Value const, BlockIter>() const
+        {
+            return {block_, index_};
+        }
+
+        template <typename V>
+        bool operator ==(dllist_unrolled_iter<V, BlockIter> const& i) const
+        {
+            return block_ == i.block_ && index_ == i.index_;
+        }
+
+        template <typename V>
+        bool operator !=(dllist_unrolled_iter<V, BlockIter> const& i) const
+        {
+            return !operator ==(i);
+        }
+
+        reference operator *() const
+        {
+            return (*block_)[index_];
+        }
+
+        pointer operator ->() const
+        {
+            return &(*block_)[index_];
+        }
+
+        dllist_unrolled_iter& operator ++()
+        {
+            if (++index_ == block_->size())
+            {
+                ++block_;
+                index_ = 0;
+            }
+            return *this;
+        }
+
+        dllist_unrolled_iter operator ++(int)
+        {
+            dllist_unrolled_iter tmp(*this);
+            operator ++();
+            return tmp;
+        }
+
+        dllist_unrolled_iter& operator --()
+        {
+            if (index_ == 0)
+            {
+                --block_;
+                index_ = block_->size();
+            }
+            --index_;
+            return *this;
+        }
+
+        dllist_unrolled_iter operator --(int)
+        {
+            dllist_unrolled_iter tmp(*this);
+            operator --();
+            return tmp;
+        }
+};
+
+//===========================================================================
+
+// Unrolled XOR list: a dllist whose nodes each hold up to N elements, so a
+// traversal pays one dependent link load per block instead of per element.
+// Full blocks are split in half on insert; a block that drops below a
+// quarter full is merged with its successor when both fit in one block.
+// Any insert or erase invalidates all iterators.
+template <typename T, std::size_t N, typename Alloc, template <typename> class LinkTraits>
+class dllist_unrolled
+{
+    private:
+        using block_type = dllist_unrolled_block<T, N>;
+        using block_allocator_type =
+            typename std::allocator_traits<Alloc>::template rebind_alloc<block_type>;
+        using blocks_type = dllist<block_type, block_allocator_type, LinkTraits>;
+        using block_iterator = typename blocks_type::iterator;
+
+        static constexpr std::size_t merge_threshold = N / 4;
+
+        blocks_type blocks_;
+        std::size_t size_;
+
+        block_iterator new_block_after(block_iterator b)
+        {
+            blocks_.emplace(std::next(b));
+            return std::next(b);
+        }
+
+        // Frees up room in a full block b, returning the block and index
+        // that now correspond to old index i.
+        std::pair<block_iterator, std::size_t> split(block_iterator b, std::size_t i)
+        {
+            auto nb = new_block_after(b);
+            auto half = N / 2;
+            b->move_tail_to(half, *nb);
+            if (i <= half)
+                return {b, i};
+            return {nb, i - half};
+        }
+
+    public:
+        using value_type = T;
+        using allocator_type = Alloc;
+
+        using reference = value_type&;
+        using const_reference = value_type const&;
+
+        using pointer = value_type*;
+        using const_pointer = value_type const*;
+
+        using iterator = dllist_unrolled_iter<T, block_iterator>;
+        using const_iterator = dllist_unrolled_iter<T const, block_iterator>;
+
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        static constexpr size_type block_capacity = N;
+
+        dllist_unrolled() :
+            dllist_unrolled{Alloc{}}
+        {}
+
+        explicit dllist_unrolled(Alloc const& alloc) :
+            blocks_{block_allocator_type{alloc}},
+            size_{}
+        {}
+
+        dllist_unrolled(std::initializer_list<T> il, Alloc const& alloc = Alloc{}) :
+            dllist_unrolled{alloc}
+        {
+            std::copy(il.begin(), il.end(), std::back_inserter(*this));
+        }
+
+        template <typename InIter>
+        dllist_unrolled(InIter const& first, InIter const& last, Alloc const& alloc = Alloc{}) :
+            dllist_unrolled{alloc}
+        {
+            std::copy(first, last, std::back_inserter(*this));
+        }
+
+        dllist_unrolled(dllist_unrolled const&) = default;
+
+        dllist_unrolled(dllist_unrolled&& l) :
+            blocks_{std::move(l.blocks_)},
+            size_{l.size_}
+        {
+            l.size_ = 0;
+        }
+
+        dllist_unrolled& operator =(dllist_unrolled const& l)
+        {
+            dllist_unrolled tmp{l};
+            this->swap(tmp);
+            return *this;
+        }
+
+        dllist_unrolled& operator =(dllist_unrolled&& l)
+        {
+            dllist_unrolled tmp{std::move(l)};
+            this->swap(tmp);
+            return *this;
+        }
+
+        ~dllist_unrolled() = default;
+
+        allocator_type get_allocator() const
+        {
+            return allocator_type{blocks_.get_allocator()};
+        }
+
+        bool empty() const
+        {
+            return size_ == 0;
+        }
+
+        size_type size() const
+        {
+            return size_;
+        }
+
+        size_type max_size() const
+        {
+            return std::numeric_limits<size_type>::max();
+        }
+
+        size_type block_count() const
+        {
+            return blocks_.size();
+        }
+
+        reference front()
+        {
+            return blocks_.front()[0];
+        }
+
+        const_reference front() const
+        {
+            return blocks_.front()[0];
+        }
+
+        reference back()
+        {
+            auto& b = blocks_.back();
+            return b[b.size() - 1];
+        }
+
+        const_reference back() const
+        {
+            auto const& b = blocks_.back();
+            return b[b.size() - 1];
+        }
+
+        iterator begin()
+        {
+            return iterator{blocks_.begin(), 0};
+        }
+
+        iterator end()
+        {
+            return iterator{blocks_.end(), 0};
+        }
+
+        // Const iterators share the mutable block iterator type so that
+        // insert and erase can take them; only element access is const.
+        const_iterator begin() const
+        {
+            return const_iterator{const_cast<blocks_type&>(blocks_).begin(), 0};
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator{const_cast<blocks_type&>(blocks_).end(), 0};
+        }
+
+        const_iterator cbegin() const
+        {
+            return begin();
+        }
+
+        const_iterator cend() const
+        {
+            return end();
+        }
+
+        reverse_iterator rbegin()
+        {
+            return reverse_iterator{end()};
+        }
+
+        reverse_iterator rend()
+        {
+            return reverse_iterator{begin()};
+        }
+
+        const_reverse_iterator rbegin() const
+        {
+            return const_reverse_iterator{end()};
+        }
+
+        const_reverse_iterator rend() const
+        {
+            return const_reverse_iterator{begin()};
+        }
+
+        const_reverse_iterator crbegin() const
+        {
+            return rbegin();
+        }
+
+        const_reverse_iterator crend() const
+        {
+            return rend();
+        }
+
+        // Calls f(pointer, count) once per block, front to back; the
+        // elements of each call are contiguous.
+        template <typename F>
+        void for_each_segment(F&& f)
+        {
+            for (auto& b : blocks_)
+                f(b.data(), b.size());
+        }
+
+        template <typename F>
+        void for_each_segment(F&& f) const
+        {
+            for (auto i = blocks_.cbegin(); i != blocks_.cend(); ++i)
+                f(i->data(), i->size());
+        }
+
+        void clear()
+        {
+            blocks_.clear();
+            size_ = 0;
+        }
+
+        void swap(dllist_unrolled& l)
+        {
+            blocks_.swap(l.blocks_);
+            std::swap(size_, l.size_);
+        }
+
+        template <typename... Args>
+        iterator emplace(const_iterator pos, Args&&... args)
+        {
+            auto bi = pos.block_;
+            auto i = pos.index_;
+            if (pos == cend())
+            {
+                if (blocks_.empty() || blocks_.back().full())
+                    blocks_.emplace_back();
+                bi = std::prev(blocks_.end());
+                i = bi->size();
+            }
+            else if (bi->full())
+            {
+                auto prev = std::prev(bi);
+                if (i == 0 && bi != blocks_.begin() && !prev->full())
+                    std::tie(bi, i) = std::make_pair(prev, prev->size());
+                else
+                    std::tie(bi, i) = split(bi, i);
+            }
+
+            try {
+                bi->emplace(i, std::forward<Args>(args)...);
+            } catch(...) {
+                // A new block, or one emptied by split() when N == 1,
+                // must not be left empty: iteration skips no blocks.
+                if (bi->empty())
+                    blocks_.erase(bi);
+                throw;
+            }
+            ++size_;
+            return iterator{bi, i};
+        }
+
+        iterator insert(const_iterator pos, value_type const& v)
+        {
+            return emplace(pos, v);
+        }
+
+        iterator insert(const_iterator pos, value_type&& v)
+        {
+            return emplace(pos, std::move(v));
+        }
+
+        template <typename... Args>
+        void emplace_back(Args&&... args)
+        {
+            emplace(cend(), std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        void emplace_front(Args&&... args)
+        {
+            emplace(cbegin(), std::forward<Args>(args)...);
+        }
+
+        void push_back(value_type const& v)
+        {
+            emplace_back(v);
+        }
+
+        void push_back(value_type&& v)
+        {
+            emplace_back(std::move(v));
+        }
+
+        void push_front(value_type const& v)
+        {
+            emplace_front(v);
+        }
+
+        void push_front(value_type&& v)
+        {
+            emplace_front(std::move(v));
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            auto b = pos.block_;
+            auto i = pos.index_;
+
+            b->erase(i);
+            --size_;
+
+            if (b->empty())
+                return iterator{blocks_.erase(b), 0};
+
+            auto next = std::next(b);
+            if (b->size() < merge_threshold
+                    && next != blocks_.end()
+                    && b->size() + next->size() <= N)
+            {
+                next->move_tail_to(0, *b);
+                next = blocks_.erase(next);
+            }
+
+            if (i < b->size())
+                return iterator{b, i};
+            return iterator{next, 0};
+        }
+
+        iterator erase(const_iterator first, const_iterator const& last)
+        {
+            auto n = std::distance(first, last);
+            auto pos = iterator{first.block_, first.index_};
+            for (; n > 0; --n)
+                pos = erase(pos);
+            return pos;
+        }
+
+        void pop_front()
+        {
+            erase(cbegin());
+        }
+
+        void pop_back()
+        {
+            erase(std::prev(cend()));
+        }
+};
+
+//===========================================================================
+
+    template <typename T, std::size_t N, typename A, template <typename> class L>
+inline void swap(dllist_unrolled<T, N, A, L>& a, dllist_unrolled<T, N, A, L>& b)
+{
+    a.swap(b);
+}
+
+    template <typename T, std::size_t N, typename A, template <typename> class L>
+inline bool operator ==(dllist_unrolled<T, N, A, L> const& a, dllist_unrolled<T, N, A, L> const& b)
+{
+    using std::equal;
+    return a.size() == b.size() && equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+    template <typename T, std::size_t N, typename A, template <typename> class L>
+inline bool operator !=(dllist_unrolled<T, N, A, L> const& a, dllist_unrolled<T, N, A, L> const& b)
+{
+    return !(a == b);
+}
+
+    template <typename T, std::size_t N, typename A, template <typename> class L>
+inline bool operator <(dllist_unrolled<T, N, A, L> const& a, dllist_unrolled<T, N, A, L> const& b)
+{
+    using std::lexicographical_compare;
+    return lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+}
+
+    template <typename T, std::size_t N, typename A, template <typename> class L>
+inline bool operator >(dllist_unrolled<T, N, A, L> const& a, dllist_unrolled<T, N, A, L> const& b)
+{
+    return b < a;
+}
+
+    template <typename T, std::size_t N, typename A, template <typename> class L>
+inline bool operator <=(dllist_unrolled<T, N, A, L> const& a, dllist_unrolled<T, N, A, L> const& b)
+{
+    return !(b < a);
+}
+
+    template <typename T, std::size_t N, typename A, template <typename> class L>
+inline bool operator >=(dllist_unrolled<T, N, A, L> const& a, dllist_unrolled<T, N, A, L> const& b)
+{
+    return !(a < b);
+}
+
+#endif // ifndef DLLIST_UNROLLED_HXX
@@ -0,0 +1,264 @@
+#ifndef NODE_POOL_HXX
+#define NODE_POOL_HXX
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+//===========================================================================
+
+// Fixed-size slab pool: blocks are carved out of geometrically growing
+// chunks and recycled through an intrusive free list. Not thread-safe.
+template <std::size_t Size, std::size_t Align>
+class node_pool
+{
+    private:
+        union block
+        {
+            block* next_;
+            alignas(Align) unsigned char storage_[Size];
+        };
+
+        struct chunk
+        {
+            chunk* next_;
+        };
+
+        static constexpr std::size_t block_align =
+            alignof(block) > alignof(chunk) ? alignof(block) : alignof(chunk);
+        static constexpr std::size_t header_size =
+            (sizeof(chunk) + block_align - 1) / block_align * block_align;
+
+        static constexpr std::size_t first_chunk_blocks = 64;
+        static constexpr std::size_t max_chunk_blocks = 4096;
+
+        block* free_;
+        block* bump_;
+        block* bump_end_;
+        chunk* chunks_;
+        std::size_t next_chunk_blocks_;
+
+        void grow()
+        {
+            auto n = next_chunk_blocks_;
+            void* raw = ::operator new(
+                    header_size + n * sizeof(block),
+                    std::align_val_t{block_align}
+                    );
+            auto c = static_cast<chunk*>(raw);
+            c->next_ = chunks_;
+            chunks_ = c;
+
+            bump_ = reinterpret_cast<block*>(
+                    static_cast<unsigned char*>(raw) + header_size);
+            bump_end_ = bump_ + n;
+
+            if (next_chunk_blocks_ < max_chunk_blocks)
+                next_chunk_blocks_ *= 2;
+        }
+
+    public:
+        static constexpr std::size_t block_size = sizeof(block);
+
+        node_pool() noexcept :
+            free_{nullptr},
+            bump_{nullptr},
+            bump_end_{nullptr},
+            chunks_{nullptr},
+            next_chunk_blocks_{first_chunk_blocks}
+        {}
+
+        node_pool(node_pool const&) = delete;
+        node_pool& operator =(node_pool const&) = delete;
+
+        ~node_pool()
+        {
+            while (chunks_)
+            {
+                auto next = chunks_->next_;
+                ::operator delete(chunks_, std::align_val_t{block_align});
+                chunks_ = next;
+            }
+        }
+
+        void* allocate()
+        {
+            if (free_)
+            {
+                auto b = free_;
+                free_ = b->next_;
+                return b;
+            }
+            if (bump_ == bump_end_)
+                grow();
+            return bump_++;
+        }
+
+        void deallocate(void* p) noexcept
+        {
+            auto b = static_cast<block*>(p);
+            b->next_ = free_;
+            free_ = b;
+        }
+};
+
+//===========================================================================
+
+// Process-wide pool for one block size, shared by every pool_allocator
+// rebound to a type of that size. Optionally fronted by a per-thread cache
+// which moves blocks to and from the shared pool in batches.
+template <std::size_t Size, std::size_t Align>
+class shared_node_pool
+{
+    private:
+        static constexpr std::size_t batch_size = 32;
+
+        std::mutex mutex_;
+        node_pool<Size, Align> pool_;
+
+        struct thread_cache
+        {
+            void* blocks_[2 * batch_size];
+            std::size_t count_ = 0;
+
+            ~thread_cache()
+            {
+                instance().give(blocks_, count_);
+                count_ = 0;
+                cache_destroyed() = true;
+            }
+        };
+
+        static shared_node_pool& instance()
+        {
+            // Never destroyed: nodes owned by static containers may still be
+            // returned after main() exits.
+            static auto p = new shared_node_pool;
+            return *p;
+        }
+
+        // Set once this thread's cache is gone; later calls from thread_local
+        // or static destructors then bypass it and use the shared pool.
+        static bool& cache_destroyed() noexcept
+        {
+            static thread_local bool destroyed = false;
+            return destroyed;
+        }
+
+        static thread_cache* cache()
+        {
+            if (cache_destroyed())
+                return nullptr;
+            static thread_local thread_cache c;
+            return &c;
+        }
+
+        void take(void** out, std::size_t n)
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            for (std::size_t i = 0; i < n; ++i)
+                out[i] = pool_.allocate();
+        }
+
+        void give(void* const* in, std::size_t n) noexcept
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            for (std::size_t i = 0; i < n; ++i)
+                pool_.deallocate(in[i]);
+        }
+
+    public:
+        static void* allocate(bool use_cache)
+        {
+            auto c = use_cache ? cache() : nullptr;
+            if (!c)
+            {
+                auto& p = instance();
+                std::lock_guard<std::mutex> lock{p.mutex_};
+                return p.pool_.allocate();
+            }
+
+            if (c->count_ == 0)
+            {
+                instance().take(c->blocks_, batch_size);
+                c->count_ = batch_size;
+            }
+            return c->blocks_[--c->count_];
+        }
+
+        static void deallocate(void* p, bool use_cache) noexcept
+        {
+            auto c = use_cache ? cache() : nullptr;
+            if (!c)
+            {
+                instance().give(&p, 1);
+                return;
+            }
+
+            if (c->count_ == 2 * batch_size)
+            {
+                c->count_ -= batch_size;
+                instance().give(c->blocks_ + c->count_, batch_size);
+            }
+            c->blocks_[c->count_++] = p;
+        }
+};
+
+//===========================================================================
+
+// Standard allocator drawing single objects from shared_node_pool. Requests
+// for more than one object go to the global operator new.
+template <typename T, bool ThreadCache = true>
+class pool_allocator
+{
+    private:
+        using pool_type = shared_node_pool<sizeof(T), alignof(T)>;
+
+    public:
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using is_always_equal = std::true_type;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = pool_allocator<U, ThreadCache>;
+        };
+
+        pool_allocator() noexcept = default;
+
+        template <typename U>
+        pool_allocator(pool_allocator<U, ThreadCache> const&) noexcept
+        {}
+
+        T* allocate(std::size_t n)
+        {
+            if (n == 1)
+                return static_cast<T*>(pool_type::allocate(ThreadCache));
+            return static_cast<T*>(
+                    ::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            if (n == 1)
+                pool_type::deallocate(p, ThreadCache);
+            else
+                ::operator delete(p, std::align_val_t{alignof(T)});
+        }
+};
+
+    template <typename T, typename U, bool C>
+inline bool operator ==(pool_allocator<T, C> const&, pool_allocator<U, C> const&)
+{
+    return true;
+}
+
+    template <typename T, typename U, bool C>
+inline bool operator !=(pool_allocator<T, C> const&, pool_allocator<U, C> const&)
+{
+    return false;
+}
+
+#endif // ifndef NODE_POOL_HXX
@@ -0,0 +1,585 @@
+// Differential test: dllist and dllist_unrolled against std::list.
+//
+// Random operation sequences are applied to both containers and their
+// contents compared, forwards and backwards, after every step. Runs with
+// the default link policy, the pooled allocator and 32-bit offset links.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../dllist.hxx"
+#include "../dllist_parallel.hxx"
+#include "../dllist_unrolled.hxx"
+#include "../node_pool.hxx"
+#include "../window_arena.hxx"
+
+#define CHECK(c) ((c) ? (void)0 : fail(#c, __FILE__, __LINE__))
+
+namespace {
+
+[[noreturn]] void fail(char const* what, char const* file, int line)
+{
+    std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, what);
+    std::abort();
+}
+
+using value = std::pair<int, int>;     // (key, unique id)
+using reference_list = std::list<value>;
+
+bool key_less(value const& a, value const& b)
+{
+    return a.first < b.first;
+}
+
+bool key_equal(value const& a, value const& b)
+{
+    return a.first == b.first;
+}
+
+template <typename List, typename Ref>
+void check_equal(List const& l, Ref const& r)
+{
+    CHECK(l.size() == r.size());
+    CHECK(std::equal(l.begin(), l.end(), r.begin(), r.end()));
+    CHECK(std::equal(l.rbegin(), l.rend(), r.rbegin(), r.rend()));
+}
+
+template <typename Iter>
+Iter nth(Iter it, std::size_t i)
+{
+    return std::next(it, static_cast<std::ptrdiff_t>(i));
+}
+
+//===========================================================================
+
+template <typename List>
+void fuzz_dllist(List a, List b, unsigned seed, int steps)
+{
+    reference_list ra, rb;
+    std::mt19937 rng{seed};
+    int id = 0;
+    auto next_value = [&] { return value{static_cast<int>(rng() % 32), id++}; };
+    auto pick = [&](std::size_t n) { return n ? rng() % n : 0; };
+
+    for (int step = 0; step < steps; ++step)
+    {
+        switch (rng() % 20)
+        {
+            case 0:
+            case 1: {
+                auto v = next_value();
+                a.push_back(v);
+                ra.push_back(v);
+                v = next_value();
+                b.push_front(v);
+                rb.push_front(v);
+                break;
+            }
+            case 2:
+                if (!ra.empty())
+                {
+                    a.pop_back();
+                    ra.pop_back();
+                }
+                if (!rb.empty())
+                {
+                    b.pop_front();
+                    rb.pop_front();
+                }
+                break;
+            case 3: {
+                auto i = pick(ra.size() + 1);
+                auto v = next_value();
+                a.insert(nth(a.begin(), i), v);
+                ra.insert(nth(ra.begin(), i), v);
+                break;
+            }
+            case 4:
+                if (!ra.empty())
+                {
+                    auto i = pick(ra.size());
+                    a.erase(nth(a.begin(), i));
+                    ra.erase(nth(ra.begin(), i));
+                }
+                break;
+            case 5: {
+                std::vector<value> vs(pick(12));
+                for (auto& v : vs)
+                    v = next_value();
+                auto i = pick(ra.size() + 1);
+                a.insert(nth(a.begin(), i), vs.begin(), vs.end());
+                ra.insert(nth(ra.begin(), i), vs.begin(), vs.end());
+                break;
+            }
+            case 6: {
+                auto i = pick(ra.size() + 1);
+                auto j = i + pick(ra.size() - i + 1);
+                a.erase(nth(a.begin(), i), nth(a.begin(), j));
+                ra.erase(nth(ra.begin(), i), nth(ra.begin(), j));
+                break;
+            }
+            case 7: {
+                auto k = pick(ra.size() + 1);
+                a.splice(nth(a.begin(), k), b);
+                ra.splice(nth(ra.begin(), k), rb);
+                break;
+            }
+            case 8:
+                if (!rb.empty())
+                {
+                    auto k = pick(ra.size() + 1);
+                    auto i = pick(rb.size());
+                    auto j = i + pick(rb.size() - i + 1);
+                    a.splice(nth(a.begin(), k), b, nth(b.begin(), i), nth(b.begin(), j));
+                    ra.splice(nth(ra.begin(), k), rb, nth(rb.begin(), i), nth(rb.begin(), j));
+                }
+                break;
+            case 9:
+                if (!ra.empty())
+                {
+                    auto k = pick(ra.size() + 1);
+                    auto i = pick(ra.size());
+                    a.splice(nth(a.begin(), k), a, nth(a.begin(), i));
+                    ra.splice(nth(ra.begin(), k), ra, nth(ra.begin(), i));
+                }
+                break;
+            case 10:
+                a.sort(key_less);
+                ra.sort(key_less);
+                b.sort(key_less);
+                rb.sort(key_less);
+                a.merge(b, key_less);
+                ra.merge(rb, key_less);
+                break;
+            case 11: {
+                auto before = ra.size();
+                auto n = a.unique(key_equal);
+                ra.unique(key_equal);
+                CHECK(n == before - ra.size());
+                break;
+            }
+            case 12: {
+                auto key = static_cast<int>(rng() % 32);
+                auto pred = [key](value const& v) { return v.first == key; };
+                a.remove_if(pred);
+                ra.remove_if(pred);
+                break;
+            }
+            case 13:
+                if (!ra.empty())
+                {
+                    // The argument refers to an element being removed.
+                    a.remove(a.front());
+                    ra.remove(value{ra.front()});
+                }
+                break;
+            case 14:
+                a.reverse();
+                ra.reverse();
+                break;
+            case 15:
+                a.swap(b);
+                ra.swap(rb);
+                break;
+            case 16: {
+                List c{std::move(a)};
+                a = std::move(b);
+                b = c;
+                std::swap(ra, rb);
+                break;
+            }
+            case 17:
+                a.enable_index(1 + pick(16));
+                break;
+            case 18:
+                if (!ra.empty())
+                {
+                    auto i = pick(ra.size());
+                    CHECK(a.at(i) == *nth(ra.begin(), i));
+                    CHECK(*a.iterator_at(i) == *nth(ra.begin(), i));
+                }
+                break;
+            case 19:
+                if (ra.size() > 300)
+                {
+                    a.clear();
+                    ra.clear();
+                }
+                break;
+        }
+        check_equal(a, ra);
+        check_equal(b, rb);
+    }
+}
+
+void test_remove_own_element()
+{
+    dllist<std::string> l{"a", "a", "b", "a"};
+    CHECK(l.remove(l.front()) == 3);
+    CHECK(l.size() == 1 && l.front() == "b");
+}
+
+void test_assignment_keeps_index()
+{
+    dllist<int> a{1, 2, 3};
+    dllist<int> b{4, 5, 6, 7};
+    a.enable_index(2);
+    a = b;
+    CHECK(a.index_stride() == 2);
+    a = dllist<int>{8, 9};
+    CHECK(a.index_stride() == 2);
+    a.assign({1, 2, 3, 4, 5});
+    CHECK(a.index_stride() == 2 && a.at(3) == 4);
+}
+
+// Operations at either end keep the index, so lookups stay short.
+void test_index_at_ends(std::size_t stride)
+{
+    dllist<int> l;
+    std::deque<int> r;
+    l.enable_index(stride);
+    std::mt19937 rng{static_cast<unsigned>(stride)};
+
+    for (int step = 0; step < 20000; ++step)
+    {
+        auto v = static_cast<int>(rng() % 1000);
+        switch (rng() % 6)
+        {
+            case 0:
+                l.push_front(v);
+                r.push_front(v);
+                break;
+            case 1:
+                l.emplace(l.begin(), v);
+                r.push_front(v);
+                break;
+            case 2:
+                l.push_back(v);
+                r.push_back(v);
+                break;
+            case 3:
+                if (!r.empty())
+                {
+                    l.pop_front();
+                    r.pop_front();
+                }
+                break;
+            case 4:
+                if (!r.empty())
+                {
+                    l.erase(l.begin());
+                    r.pop_front();
+                }
+                break;
+            case 5:
+                if (!r.empty())
+                {
+                    l.pop_back();
+                    r.pop_back();
+                }
+                break;
+        }
+        if (r.empty())
+            continue;
+
+        // The middle moves by at most one element per step, so the lookup
+        // adds at most one checkpoint instead of rebuilding the index.
+        auto i = r.size() / 2;
+        auto before = dllist_stats_snapshot();
+        CHECK(l.at(i) == r[i]);
+        auto after = dllist_stats_snapshot();
+        CHECK(after.traversal_steps - before.traversal_steps <= 2 * stride);
+
+        i = rng() % r.size();
+        CHECK(l.at(i) == r[i]);
+    }
+}
+
+// Internal walks count one step per node visited.
+void test_stats()
+{
+#ifdef DLLIST_ENABLE_STATS
+    dllist<int> l;
+    for (int i = 0; i < 100; ++i)
+        l.push_back(100 - i);
+
+    auto before = dllist_stats_snapshot();
+    l.sort();
+    auto sorted = dllist_stats_snapshot();
+    l.clear();
+    auto cleared = dllist_stats_snapshot();
+
+    CHECK(sorted.traversal_steps > before.traversal_steps);
+    CHECK(cleared.traversal_steps - sorted.traversal_steps == 100);
+    CHECK(cleared.node_frees - sorted.node_frees == 100);
+#endif
+}
+
+//===========================================================================
+
+// Stateful allocator whose propagation traits are chosen per test.
+template <typename T, bool Propagate>
+class tagged_allocator
+{
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::bool_constant<Propagate>;
+        using propagate_on_container_move_assignment = std::bool_constant<Propagate>;
+        using propagate_on_container_swap = std::bool_constant<Propagate>;
+
+        int tag;
+
+        explicit tagged_allocator(int t = 0) noexcept :
+            tag{t}
+        {}
+
+        template <typename U>
+        tagged_allocator(tagged_allocator<U, Propagate> const& a) noexcept :
+            tag{a.tag}
+        {}
+
+        template <typename U>
+        struct rebind
+        {
+            using other = tagged_allocator<U, Propagate>;
+        };
+
+        T* allocate(std::size_t n)
+        {
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template <typename U>
+        bool operator ==(tagged_allocator<U, Propagate> const& a) const noexcept
+        {
+            return tag == a.tag;
+        }
+
+        template <typename U>
+        bool operator !=(tagged_allocator<U, Propagate> const& a) const noexcept
+        {
+            return tag != a.tag;
+        }
+};
+
+template <bool Propagate>
+void test_allocator_propagation()
+{
+    using alloc = tagged_allocator<int, Propagate>;
+    using list = dllist<int, alloc>;
+
+    list a({1, 2}, alloc{1});
+    list b({3, 4, 5}, alloc{2});
+    a = std::move(b);
+    CHECK(a.size() == 3 && a.front() == 3);
+    CHECK(a.get_allocator().tag == (Propagate ? 2 : 1));
+
+    list c({6}, alloc{3});
+    a = c;
+    CHECK(a.size() == 1 && a.front() == 6);
+    CHECK(a.get_allocator().tag == (Propagate ? 3 : 1));
+
+    list d({7, 8}, alloc{Propagate ? 4 : 1});
+    a.swap(d);
+    CHECK(a.size() == 2 && d.front() == 6);
+    CHECK(a.get_allocator().tag == (Propagate ? 4 : 1));
+}
+
+//===========================================================================
+
+void test_parallel()
+{
+    dllist<long> l;
+    for (long i = 0; i < 1000; ++i)
+        l.push_back(i);
+    auto expected = 100 + 999L * 1000 / 2;
+
+    for (std::size_t stride : { 0, 1, 7, 300, 5000 })
+    {
+        l.enable_index(stride);
+        for (unsigned threads : { 1, 2, 3, 8 })
+        {
+            auto sum = parallel_transform_reduce(l, 100L,
+                    [](long x, long y) { return x + y; },
+                    [](long x) { return x; }, threads);
+            CHECK(sum == expected);
+        }
+    }
+
+    dllist<long> empty;
+    CHECK(parallel_transform_reduce(empty, 5L,
+                [](long x, long y) { return x + y; },
+                [](long x) { return x; }) == 5);
+
+    parallel_for_each(l, [](long& x) { x *= 2; }, 4);
+    CHECK(std::accumulate(l.begin(), l.end(), 0L) == 999L * 1000);
+}
+
+//===========================================================================
+
+void fuzz_unrolled(unsigned seed, int steps)
+{
+    dllist_unrolled<int, 8> l;
+    std::list<int> r;
+    std::mt19937 rng{seed};
+    auto pick = [&](std::size_t n) { return n ? rng() % n : 0; };
+
+    for (int step = 0; step < steps; ++step)
+    {
+        auto v = static_cast<int>(rng() % 1000);
+        switch (rng() % 8)
+        {
+            case 0:
+                l.push_back(v);
+                r.push_back(v);
+                break;
+            case 1:
+                l.push_front(v);
+                r.push_front(v);
+                break;
+            case 2:
+            case 3: {
+                auto i = pick(r.size() + 1);
+                auto it = l.insert(nth(l.cbegin(), i), v);
+                r.insert(nth(r.begin(), i), v);
+                CHECK(*it == v);
+                break;
+            }
+            case 4:
+                if (!r.empty())
+                {
+                    auto i = pick(r.size());
+                    auto it = l.erase(nth(l.cbegin(), i));
+                    auto rit = r.erase(nth(r.begin(), i));
+                    CHECK((it == l.end()) == (rit == r.end()));
+                    if (rit != r.end())
+                        CHECK(*it == *rit);
+                }
+                break;
+            case 5: {
+                auto i = pick(r.size() + 1);
+                auto j = i + pick(r.size() - i + 1);
+                l.erase(nth(l.cbegin(), i), nth(l.cbegin(), j));
+                r.erase(nth(r.begin(), i), nth(r.begin(), j));
+                break;
+            }
+            case 6:
+                if (!r.empty())
+                {
+                    l.pop_back();
+                    r.pop_back();
+                }
+                if (!r.empty())
+                {
+                    l.pop_front();
+                    r.pop_front();
+                }
+                break;
+            case 7:
+                if (r.size() > 400)
+                {
+                    l.clear();
+                    r.clear();
+                }
+                break;
+        }
+        check_equal(l, r);
+        CHECK(l.block_count() <= r.size());
+    }
+
+    auto copy = l;
+    check_equal(copy, r);
+}
+
+struct throws_on_negative
+{
+    int v;
+
+    throws_on_negative(int x) :
+        v{x}
+    {
+        if (x < 0)
+            throw 0;
+    }
+
+    bool operator ==(int x) const
+    {
+        return v == x;
+    }
+};
+
+// A throwing constructor must not leave an empty block behind.
+template <std::size_t N>
+void test_unrolled_throwing_emplace()
+{
+    dllist_unrolled<throws_on_negative, N> l;
+    std::list<int> r{0, 1, 2, 3};
+    for (int x : r)
+        l.emplace_back(x);
+
+    auto expect_throw = [&](auto const& pos) {
+        bool thrown = false;
+        try {
+            l.emplace(pos, -1);
+        } catch (int) {
+            thrown = true;
+        }
+        CHECK(thrown);
+        l.for_each_segment([](auto*, std::size_t n) { CHECK(n > 0); });
+        CHECK(l.size() == r.size());
+        CHECK(std::equal(l.begin(), l.end(), r.begin(), r.end()));
+    };
+    expect_throw(l.cend());
+    expect_throw(nth(l.cbegin(), 1));
+    expect_throw(l.cbegin());
+
+    l.emplace_back(4);
+    r.push_back(4);
+    CHECK(std::equal(l.begin(), l.end(), r.begin(), r.end()));
+}
+
+} // namespace
+
+int main()
+{
+    for (unsigned seed = 1; seed <= 4; ++seed)
+        fuzz_dllist(dllist<value>{}, dllist<value>{}, seed, 4000);
+
+    using pooled = dllist<value, pool_allocator<value>>;
+    fuzz_dllist(pooled{}, pooled{}, 5, 4000);
+
+    window_arena arena;
+    using window_alloc = window_allocator<value>;
+    using offset32 = dllist<value, window_alloc, xorptr_offset32_traits>;
+    fuzz_dllist(offset32{window_alloc{arena}}, offset32{window_alloc{arena}}, 6, 4000);
+
+    test_remove_own_element();
+    test_assignment_keeps_index();
+    test_stats();
+    for (std::size_t stride : {1, 3, 16})
+        test_index_at_ends(stride);
+    test_allocator_propagation<true>();
+    test_allocator_propagation<false>();
+    test_parallel();
+
+    for (unsigned seed = 1; seed <= 4; ++seed)
+        fuzz_unrolled(seed, 4000);
+    test_unrolled_throwing_emplace<1>();
+    test_unrolled_throwing_emplace<4>();
+
+    std::puts("ok");
+}
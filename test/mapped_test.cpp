@@ -0,0 +1,204 @@
+// Round trip through the mapped file format: dllist_save, dllist_load,
+// appending with dllist_file_writer and refreshing a live view, the
+// copy-on-write view, and rejection of foreign or corrupt headers.
+//
+//   ./mapped_test [scratch_file]
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <list>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../dllist_mapped.hxx"
+
+#define CHECK(c) ((c) ? (void)0 : fail(#c, __FILE__, __LINE__))
+
+namespace {
+
+[[noreturn]] void fail(char const* what, char const* file, int line)
+{
+    std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, what);
+    std::abort();
+}
+
+struct record
+{
+    int key;
+    double weight;
+};
+
+template <typename View, typename Ref>
+void check_equal(View const& v, Ref const& r)
+{
+    CHECK(v.size() == r.size());
+    CHECK(std::equal(v.begin(), v.end(), r.begin(), r.end()));
+    CHECK(std::equal(v.rbegin(), v.rend(), r.rbegin(), r.rend()));
+}
+
+template <typename View>
+bool rejected(char const* path)
+{
+    try
+    {
+        View v{path};
+    }
+    catch (std::runtime_error const&)
+    {
+        return true;
+    }
+    return false;
+}
+
+//===========================================================================
+
+void test_save_append_refresh(char const* path)
+{
+    dllist<int> l;
+    std::list<int> r;
+    for (int i = 0; i < 1000; ++i)
+    {
+        l.push_back(i);
+        r.push_back(i);
+    }
+    dllist_save(l, path);
+
+    dllist_mapped_view<int> v{path};
+    check_equal(v, r);
+    CHECK(v.front() == 0 && v.back() == 999);
+    CHECK(dllist_load<int>(path) == l);
+
+    {
+        dllist_file_writer<int> w{path, true};
+        for (int i = 1000; i < 1100; ++i)
+        {
+            w.push_back(i);
+            r.push_back(i);
+            if (i % 7 == 0)
+                w.flush();
+        }
+    }
+    v.refresh();
+    check_equal(v, r);
+}
+
+// A view that is never refreshed picks up flushed appends by itself.
+template <bool CopyOnWrite>
+void test_live_view(char const* path)
+{
+    dllist<int> l;
+    std::list<int> r;
+    for (int i = 0; i < 10; ++i)
+    {
+        l.push_back(i);
+        r.push_back(i);
+    }
+    dllist_save(l, path);
+
+    dllist_mapped_view<int, CopyOnWrite> v{path};
+    dllist_file_writer<int> w{path, true};
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 5000; ++i)
+        {
+            w.push_back(i);
+            r.push_back(i);
+        }
+        w.flush();
+        check_equal(v, r);
+        CHECK(v.back() == 4999);
+    }
+}
+
+void test_copy_on_write(char const* path)
+{
+    dllist<int> l{0, 1, 2, 3};
+    dllist_save(l, path);
+
+    dllist_mapped_view<int, true> c{path};
+    for (auto& x : c)
+        x *= 2;
+    CHECK(*std::next(c.begin()) == 2);
+
+    dllist_mapped_view<int> v{path};
+    check_equal(v, l);
+}
+
+// Streams past the writer's automatic flush, then shrinks the file under
+// a live view.
+void test_large_records(char const* path)
+{
+    dllist_save(dllist<record>{}, path);
+    dllist_mapped_view<record> v{path};
+    CHECK(v.empty() && v.begin() == v.end());
+
+    constexpr int n = 200000;
+    {
+        dllist_file_writer<record> w{path, true};
+        for (int i = 0; i < n; ++i)
+            w.push_back(record{i, i * 0.5});
+    }
+    v.refresh();
+    CHECK(v.size() == n);
+    int k = 0;
+    for (auto const& x : v)
+        CHECK(x.key == k++);
+    for (auto it = v.rbegin(); it != v.rend(); ++it)
+        CHECK(it->key == --k);
+
+    dllist<record> one;
+    one.push_back(record{7, 1.0});
+    dllist_save(one, path);
+    v.refresh();
+    CHECK(v.size() == 1 && v.front().key == 7);
+}
+
+template <typename Corrupt>
+void check_corrupt_rejected(char const* path, Corrupt corrupt)
+{
+    dllist_save(dllist<int>{1, 2, 3}, path);
+
+    int fd = ::open(path, O_RDWR);
+    CHECK(fd >= 0);
+    dllist_file_header h;
+    CHECK(::pread(fd, &h, sizeof h, 0) == sizeof h);
+    corrupt(h);
+    CHECK(::pwrite(fd, &h, sizeof h, 0) == sizeof h);
+    ::close(fd);
+
+    CHECK(rejected<dllist_mapped_view<int>>(path));
+}
+
+void test_bad_headers(char const* path)
+{
+    dllist_save(dllist<int>{1, 2, 3}, path);
+    CHECK(rejected<dllist_mapped_view<record>>(path));
+
+    check_corrupt_rejected(path, [](dllist_file_header& h) { h.magic[0] ^= 1; });
+    check_corrupt_rejected(path, [](dllist_file_header& h) { h.front = 0x10000000; });
+    check_corrupt_rejected(path, [](dllist_file_header& h) { h.back = 0x10000000; });
+    check_corrupt_rejected(path, [](dllist_file_header& h) { h.count = 4; });
+    check_corrupt_rejected(path, [](dllist_file_header& h) { h.count = ~h.count; });
+    check_corrupt_rejected(path, [](dllist_file_header& h) { h.end = 8; });
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    char const* path = argc > 1 ? argv[1] : "mapped_test.dll";
+
+    test_save_append_refresh(path);
+    test_live_view<false>(path);
+    test_live_view<true>(path);
+    test_copy_on_write(path);
+    test_large_records(path);
+    test_bad_headers(path);
+
+    ::unlink(path);
+    std::puts("ok");
+}
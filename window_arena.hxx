@@ -0,0 +1,219 @@
+#ifndef WINDOW_ARENA_HXX
+#define WINDOW_ARENA_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include <sys/mman.h>
+
+#include "xorptr.hxx"
+
+//===========================================================================
+
+// A 4 GiB range of address space aligned to 4 GiB, reserved without access
+// rights. Users commit or map pages inside it; everything is released on
+// destruction.
+class window_reservation
+{
+    private:
+        void* mapping_;
+        std::size_t mapping_size_;
+        unsigned char* base_;
+
+    public:
+        static constexpr std::size_t window_size = std::size_t{1} << 32;
+
+        window_reservation()
+        {
+            // Over-reserve so that an aligned window fits inside the mapping.
+            mapping_size_ = 2 * window_size;
+            mapping_ = ::mmap(nullptr, mapping_size_, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (mapping_ == MAP_FAILED)
+                throw std::bad_alloc{};
+
+            auto addr = reinterpret_cast<std::uintptr_t>(mapping_);
+            auto aligned = (addr + window_size - 1) & ~(window_size - 1);
+            base_ = reinterpret_cast<unsigned char*>(aligned);
+        }
+
+        window_reservation(window_reservation const&) = delete;
+        window_reservation& operator =(window_reservation const&) = delete;
+
+        ~window_reservation()
+        {
+            ::munmap(mapping_, mapping_size_);
+        }
+
+        unsigned char* base() const noexcept
+        {
+            return base_;
+        }
+};
+
+//===========================================================================
+
+// Arena living inside one 4 GiB-aligned window of address space. Every
+// address it hands out shares the same upper 32 bits, which is what
+// xorptr_offset32_traits relies on to store links in 32 bits.
+//
+// The window is only reserved up front; pages are made accessible in
+// commit_step increments as the bump pointer advances. Freed blocks are
+// recycled through per-size free lists. Not thread-safe; must outlive every
+// container allocating from it.
+class window_arena
+{
+    private:
+        static constexpr std::size_t window_size = window_reservation::window_size;
+        static constexpr std::size_t commit_step = std::size_t{1} << 20;
+        static constexpr std::size_t granularity = 8;
+        static constexpr std::size_t size_classes = 64;
+
+        struct free_block
+        {
+            free_block* next_;
+        };
+
+        window_reservation window_;
+        unsigned char* base_;
+        std::size_t used_;
+        std::size_t committed_;
+        free_block* free_[size_classes];
+
+        static std::size_t size_class(std::size_t bytes) noexcept
+        {
+            return (bytes + granularity - 1) / granularity - 1;
+        }
+
+        void commit(std::size_t end)
+        {
+            auto new_committed = (end + commit_step - 1) / commit_step * commit_step;
+            if (new_committed > window_size
+                    || ::mprotect(base_ + committed_, new_committed - committed_,
+                        PROT_READ | PROT_WRITE) != 0)
+                throw std::bad_alloc{};
+            committed_ = new_committed;
+        }
+
+    public:
+        static constexpr std::size_t max_block_size = granularity * size_classes;
+        static constexpr std::size_t max_align = granularity;
+
+        window_arena() :
+            base_{window_.base()},
+            used_{},
+            committed_{},
+            free_{}
+        {}
+
+        window_arena(window_arena const&) = delete;
+        window_arena& operator =(window_arena const&) = delete;
+
+        void* allocate(std::size_t bytes)
+        {
+            if (bytes == 0)
+                bytes = 1;
+            if (bytes > max_block_size)
+                throw std::bad_alloc{};
+
+            auto c = size_class(bytes);
+            if (auto b = free_[c])
+            {
+                free_[c] = b->next_;
+                return b;
+            }
+
+            auto block_bytes = (c + 1) * granularity;
+            if (used_ + block_bytes > committed_)
+                commit(used_ + block_bytes);
+            auto p = base_ + used_;
+            used_ += block_bytes;
+            return p;
+        }
+
+        void deallocate(void* p, std::size_t bytes) noexcept
+        {
+            if (bytes == 0)
+                bytes = 1;
+            auto c = size_class(bytes);
+            auto b = static_cast<free_block*>(p);
+            b->next_ = free_[c];
+            free_[c] = b;
+        }
+
+        bool owns(void const* p) const noexcept
+        {
+            auto b = static_cast<unsigned char const*>(p);
+            return b >= base_ && b < base_ + used_;
+        }
+};
+
+//===========================================================================
+
+// Standard allocator over a window_arena. Pair it with
+// xorptr_offset32_traits, e.g.
+//
+//   window_arena arena;
+//   dllist<std::uint32_t, window_allocator<std::uint32_t>,
+//       xorptr_offset32_traits> l{window_allocator<std::uint32_t>{arena}};
+template <typename T>
+class window_allocator
+{
+    private:
+        template <typename> friend class window_allocator;
+
+        window_arena* arena_;
+
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        explicit window_allocator(window_arena& arena) noexcept :
+            arena_{&arena}
+        {}
+
+        template <typename U>
+        window_allocator(window_allocator<U> const& a) noexcept :
+            arena_{a.arena_}
+        {}
+
+        T* allocate(std::size_t n)
+        {
+            static_assert(alignof(T) <= window_arena::max_align,
+                    "window_arena cannot satisfy this alignment");
+            static_assert(sizeof(T) <= window_arena::max_block_size,
+                    "window_arena blocks are too small for this type");
+            return static_cast<T*>(arena_->allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            arena_->deallocate(p, n * sizeof(T));
+        }
+
+        window_arena& arena() const noexcept
+        {
+            return *arena_;
+        }
+
+        template <typename U>
+        bool operator ==(window_allocator<U> const& a) const noexcept
+        {
+            return arena_ == a.arena_;
+        }
+
+        template <typename U>
+        bool operator !=(window_allocator<U> const& a) const noexcept
+        {
+            return arena_ != a.arena_;
+        }
+};
+
+template <typename T>
+struct allocator_uses_window<window_allocator<T>> : std::true_type {};
+
+#endif // ifndef WINDOW_ARENA_HXX
@@ -1,59 +1,77 @@
-//#define CXX_XOR_PROJECT_USE_UINPTR_T
-//#define CXX_XOR_PROJECT_USE_REINTERPRET_CAST 
+#ifndef XORPTR_HXX
+#define XORPTR_HXX
 
-#if defined(CXX_XOR_PROJECT_USE_REINTERPRET_CAST) \
-    && defined(CXX_XOR_PROJECT_USE_UINTPTR_T)
-#error "Only define one CXX_XOR_PROJECT_USE_XXX macro!"
-#endif
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
 
-#if !defined(CXX_XOR_PROJECT_USE_REINTERPRET_CAST) \
-    && !defined(CXX_XOR_PROJECT_USE_UINTPTR_T)
-#error "Must define one CXX_XOR_PROJECT_USE_XXX macro!"
+#if __cplusplus > 201703L && __has_include(<bit>)
+#include <bit>
 #endif
 
-#ifdef CXX_XOR_PROJECT_USE_UINTPTR_T
+// Link policies. Each xorptr_traits-like template maps a pair of node
+// pointers to a stored link value (create) and recovers one pointer of the
+// pair from the link and the other (extract). The policy is picked per
+// container through the LinkTraits template parameter.
+
+// Default policy: the link is the XOR of the two addresses as a uintptr_t,
+// computed with one register XOR.
 template <typename T>
 struct xorptr_traits final
 {
     using pointer_type = T*;
     using const_pointer_type = T const*;
-    using xorptr_type = uintptr_t;
-    static xorptr_type create() noexcept
+    using xorptr_type = std::uintptr_t;
+
+    static constexpr xorptr_type create() noexcept
     {
-        return create(static_cast<T*>(nullptr), static_cast<T*>(nullptr));
+        return 0;
     }
-    static xorptr_type create(pointer_type p1, pointer_type p2) noexcept
-    {
-        return
-            reinterpret_cast<uintptr_t>(p1)
-            ^ reinterpret_cast<uintptr_t>(p2)
-            ; }
+
     static xorptr_type create(
             const_pointer_type p1, const_pointer_type p2) noexcept
-    { return
-        reinterpret_cast<uintptr_t>(p1)
-            ^ reinterpret_cast<uintptr_t>(p2)
-            ;
+    {
+        return to_bits(p1) ^ to_bits(p2);
     }
+
     static pointer_type extract(
             xorptr_type const& xp, pointer_type p) noexcept
-    { return
-        static_cast<T*>(
-                reinterpret_cast<void*>(xp ^ reinterpret_cast<uintptr_t>(p))
-                ) ;
+    {
+        return from_bits<pointer_type>(xp ^ to_bits(p));
     }
+
     static const_pointer_type extract(
             xorptr_type const& xp, const_pointer_type p) noexcept
-    { return
-        static_cast<T const*>(
-                reinterpret_cast<void const*>(xp ^
-                    reinterpret_cast<uintptr_t>(p)
-                    )
-                ) ;
-    } };
-#elif defined(CXX_XOR_PROJECT_USE_REINTERPRET_CAST)
+    {
+        return from_bits<const_pointer_type>(xp ^ to_bits(p));
+    }
+
+    private:
+    static xorptr_type to_bits(const_pointer_type p) noexcept
+    {
+#ifdef __cpp_lib_bit_cast
+        return std::bit_cast<xorptr_type>(p);
+#else
+        return reinterpret_cast<xorptr_type>(p);
+#endif
+    }
+
+    template <typename P>
+    static P from_bits(xorptr_type x) noexcept
+    {
+#ifdef __cpp_lib_bit_cast
+        return std::bit_cast<P>(x);
+#else
+        return reinterpret_cast<P>(x);
+#endif
+    }
+};
+
+// Original policy: XORs the object representations of the two pointers
+// byte by byte through volatile copies. Kept as a portable reference and
+// as the baseline in bench/xorptr_traits_bench.cpp.
 template<typename T>
-struct xorptr_traits final
+struct xorptr_bytewise_traits final
 {
     using pointer_type = T*;
     using const_pointer_type = T const*;
@@ -174,12 +192,71 @@ struct xorptr_traits final
         return static_cast<const_pointer_type>(vp1);
     }
 };
-#endif
-template<typename T>
+
+// Stores the XOR of two pointers in 32 bits. Only valid when both pointers
+// share their upper 32 address bits, i.e. all linked nodes live in the same
+// 4 GiB-aligned window (see window_arena in window_arena.hxx). The stored
+// value is then the XOR of the nodes' offsets into that window.
+template <typename T>
+struct xorptr_offset32_traits final
+{
+    using pointer_type = T*;
+    using const_pointer_type = T const*;
+    using xorptr_type = std::uint32_t;
+
+    static constexpr xorptr_type create() noexcept
+    {
+        return 0;
+    }
+
+    static xorptr_type create(
+            const_pointer_type p1, const_pointer_type p2) noexcept
+    {
+        auto x = reinterpret_cast<std::uintptr_t>(p1)
+            ^ reinterpret_cast<std::uintptr_t>(p2);
+        assert((x >> 16 >> 16) == 0 && "nodes outside one 4 GiB window");
+        return static_cast<xorptr_type>(x);
+    }
+
+    static pointer_type extract(
+            xorptr_type const& xp, pointer_type p) noexcept
+    {
+        return reinterpret_cast<pointer_type>(
+                reinterpret_cast<std::uintptr_t>(p) ^ xp);
+    }
+
+    static const_pointer_type extract(
+            xorptr_type const& xp, const_pointer_type p) noexcept
+    {
+        return reinterpret_cast<const_pointer_type>(
+                reinterpret_cast<std::uintptr_t>(p) ^ xp);
+    }
+};
+
+// Whether the link policy needs every linked node in one 4 GiB-aligned
+// window. Containers then require an allocator that opts in through
+// allocator_uses_window.
+template <template <typename> class Traits>
+struct xorptr_needs_window : std::false_type {};
+
+template <>
+struct xorptr_needs_window<xorptr_offset32_traits> : std::true_type {};
+
+// Whether every address Alloc hands out lies in one 4 GiB-aligned window.
+// Specialised for window_allocator in window_arena.hxx.
+template <typename Alloc>
+struct allocator_uses_window : std::false_type {};
+
+// Whether every node a link may refer to, sentinels included, has to come
+// from the container's allocator. Containers otherwise embed their sentinels.
+template <template <typename> class Traits>
+struct xorptr_needs_allocated_sentinels : xorptr_needs_window<Traits> {};
+
+template<typename T, template <typename> class Traits = xorptr_traits>
 class xorptr final
 {
     public:
-        using traits_type = xorptr_traits<T>;
+        using traits_type = Traits<T>;
         using pointer_type = typename traits_type::pointer_type;
         using const_pointer_type = typename traits_type::const_pointer_type;
 
@@ -187,7 +264,7 @@ class xorptr final
         using xorptr_type = typename traits_type::xorptr_type;
         xorptr_type xorptr_;
     public:
-        xorptr() noexcept:
+        constexpr xorptr() noexcept:
             xorptr_{traits_type::create()}
         {}
 
@@ -222,3 +299,5 @@ class xorptr final
             return traits_type::extract(xorptr_, b);
         }
 };
+
+#endif // ifndef XORPTR_HXX